@@ -0,0 +1,307 @@
+#include "dlx.hpp"
+#include "generators.hpp"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <sys/time.h>
+
+using namespace std;
+using namespace kpfp;
+
+/*
+ * Benchmark on generated problems.
+ *
+ * Usage: bench [trail] [sample | first | prefetch] queens N | langford N | pentominoes W H | soma | random R C K
+ *
+ * Prints the size of the matrix, the number of solutions and the time it
+ * took to build the matrix and to count the solutions.
+ *
+ * With sample, draws random solutions for about a second with each
+ * sampler instead and prints samples/s: sample() with a count cache,
+ * sample() without one (for small problems), the ZDD from compile()
+ * (after the time to build it) and sampleApprox().
+ *
+ * With first, measures time to the first solution over 500 trials, each
+ * on the matrix with its rows and columns in a different random order, and
+ * prints p50, p99 and max for search() and for searchRestarts() (Luby
+ * schedule, seeded by the trial). search() gives up after 2e7 nodes; such
+ * trials count with the time spent so far, so its figures are then lower
+ * bounds. Pick a problem that has solutions.
+ *
+ * With prefetch, covers and uncovers every 7th column in turn, sweep after
+ * sweep for about a second, with prefetching off and then on whatever the
+ * arena size (see dlx::prefetchNodes), three times over, and prints
+ * sweeps/s. Built with DLX_NO_PREFETCH, both settings do the same.
+ *
+ * With trail, the solver undoes covers from a trail (dlx::trailTraits)
+ * instead of dancing the links back, so that any of the figures above can
+ * be compared with and without it.
+ *
+ * random R C K is a matrix of R rows, each with K distinct columns out of C,
+ * drawn with a fixed seed: large ones show what happens once the arena
+ * no longer fits in the cache.
+ */
+
+template <class Traits>
+struct Counter : public dlxSolver<Counter<Traits>, Traits> {
+	typedef dlxSolver<Counter<Traits>, Traits> base;
+	unsigned long found; /* Solutions reported */
+	bool first; /* Halt at the first solution */
+	unsigned long nodes; /* Rows selected by search */
+	unsigned long cap; /* Halt after this many rows selected, 0 for no limit */
+
+	Counter() : found(0), first(false), nodes(0), cap(0) {}
+	void solution(unsigned int) {
+		++found;
+		this->halt = first;
+	}
+	void enter(unsigned int, typename base::link) {
+		if(cap && ++nodes >= cap)
+			this->halt = true;
+	}
+
+	/*
+	 * Prefetch in cover and uncover always, or never.
+	 */
+	void setPrefetch(bool on) { this->prefetchFrom = on ? 0 : static_cast<size_t>(-1); }
+
+	/*
+	 * Cover and uncover every 7th column.
+	 */
+	void sweep() {
+		for(size_t c=1; c<this->h.size(); c+=7) {
+			this->cover(c);
+			this->uncover(c);
+		}
+	}
+};
+
+/*
+ * Rows of a problem, kept to be added to a solver in another order.
+ */
+struct Rows {
+	unsigned int p, s; /* Primary and secondary columns */
+	vector<vector<unsigned int> > r; /* Rows */
+
+	void setColumnNumber(unsigned int p_, unsigned int s_=0) {
+		p = p_;
+		s = s_;
+	}
+	void reserve(size_t n, size_t) { r.reserve(n); }
+	template <class InputIterator>
+	unsigned int addRow(InputIterator it, InputIterator end) {
+		r.push_back(vector<unsigned int>(it, end));
+		return r.size() - 1;
+	}
+};
+
+static double now() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+/*
+ * Fill s with the problem named p, false if there is no such problem.
+ */
+template <class Solver>
+static bool build(Solver &s, const string &p, int a, int b, int c) {
+	if(p == "queens" && a > 0)
+		gen::queens(s, a);
+	else if(p == "langford" && a > 0)
+		gen::langford(s, a);
+	else if(p == "pentominoes" && a > 0 && b > 0)
+		gen::pack(s, gen::pentominoes(), a, b);
+	else if(p == "soma")
+		gen::pack(s, gen::soma(), 3, 3, 3);
+	else if(p == "random" && a > 0 && b > 0 && c > 0 && c <= b) {
+		dlx::rng g(1);
+		s.setColumnNumber(b);
+		s.reserve(a, static_cast<size_t>(a) * c);
+		vector<unsigned int> row;
+		for(int i=0; i<a; ++i) {
+			row.clear();
+			while(row.size() < static_cast<size_t>(c)) {
+				unsigned int x = 1 + g.below(b);
+				if(find(row.begin(), row.end(), x) == row.end())
+					row.push_back(x);
+			}
+			sort(row.begin(), row.end());
+			s.addRow(row.begin(), row.end());
+		}
+	} else
+		return false;
+	return true;
+}
+
+/*
+ * Print the rate of a sampler.
+ */
+static void rate(const char *name, unsigned long n, double t) {
+	cout << "  " << name << ": " << n << " samples in " << t << " s, " << n / t << " samples/s\n";
+}
+
+static const double period = 1.0; /* Seconds per sampler */
+
+template <class Traits>
+static void sample(Counter<Traits> &s) {
+	dlx::rng g(1);
+	unsigned long n = 0;
+	double t = now(), t0 = t;
+	dlx::countCache cache(64 << 20);
+	for(; t - t0 < period; t = now(), ++n)
+		if(!s.sample(g, &cache))
+			break;
+	rate("sample, cached", n, t - t0);
+
+	if(s.rowCount() <= 1000) { // every sample recounts the whole tree
+		n = 0;
+		t = t0 = now();
+		for(; t - t0 < period; t = now(), ++n)
+			if(!s.sample(g, 0))
+				break;
+		rate("sample, uncached", n, t - t0);
+	}
+
+	t0 = now();
+	dlx::zdd z;
+	s.compile(z, 64 << 20);
+	cout << "  zdd built: " << z.size() << " vertices in " << now() - t0 << " s\n";
+	vector<unsigned int> rows;
+	n = 0;
+	t = t0 = now();
+	for(; t - t0 < period; t = now(), ++n)
+		if(!z.sample(g, rows))
+			break;
+	rate("zdd", n, t - t0);
+
+	n = 0;
+	t = t0 = now();
+	for(; t - t0 < period; t = now(), ++n)
+		if(!s.sampleApprox(g))
+			break;
+	rate("approximate", n, t - t0);
+}
+
+/*
+ * Print percentiles of times to the first solution.
+ */
+static void percentiles(const char *name, vector<double> &t, unsigned int capped) {
+	sort(t.begin(), t.end());
+	cout << "  " << name << ": p50 " << t[t.size() / 2] << " s, p99 " << t[t.size() * 99 / 100]
+	     << " s, max " << t.back() << " s";
+	if(capped)
+		cout << " (" << capped << " runs cut off)";
+	cout << "\n";
+}
+
+static const unsigned int trials = 500; /* Matrices timed by first */
+
+template <class Traits>
+static void prefetch(Counter<Traits> &s) {
+	for(int round=0; round<3; ++round)
+		for(int on=0; on<2; ++on) {
+			s.setPrefetch(on);
+			unsigned long n = 0;
+			double t = now(), t0 = t;
+			for(; t - t0 < period; t = now(), ++n)
+				s.sweep();
+			cout << "  prefetch " << (on ? "on" : "off") << ": " << n / (t - t0) << " sweeps/s\n";
+		}
+}
+
+template <class Traits>
+static void first(const Rows &m) {
+	const unsigned long cap = 20000000;
+	vector<double> det, rnd;
+	unsigned int capped = 0;
+	dlx::rng shuffle(12345);
+	vector<unsigned int> order(m.r.size()), col(m.p + m.s + 1), row;
+	for(unsigned int i=0; i<order.size(); ++i)
+		order[i] = i;
+	for(unsigned int i=0; i<col.size(); ++i)
+		col[i] = i;
+	for(unsigned int i=0; i<trials; ++i) {
+		for(unsigned int j=order.size(); j>1; --j)
+			swap(order[j-1], order[shuffle.below(j)]);
+		for(unsigned int j=m.p; j>1; --j) // primary columns among themselves
+			swap(col[j], col[1 + shuffle.below(j)]);
+		for(unsigned int j=m.s; j>1; --j) // and secondary ones
+			swap(col[m.p + j], col[m.p + 1 + shuffle.below(j)]);
+		Counter<Traits> s;
+		s.setColumnNumber(m.p, m.s);
+		for(unsigned int j=0; j<order.size(); ++j) {
+			const vector<unsigned int> &r = m.r[order[j]];
+			row.resize(r.size());
+			for(unsigned int k=0; k<r.size(); ++k)
+				row[k] = col[r[k]];
+			sort(row.begin(), row.end());
+			s.addRow(row.begin(), row.end());
+		}
+		s.first = true;
+		s.cap = cap;
+		double t = now();
+		s.search();
+		det.push_back(now() - t);
+		capped += s.nodes >= cap;
+		s.cap = 0;
+		dlx::rng g(i + 1);
+		t = now();
+		s.searchRestarts(g);
+		rnd.push_back(now() - t);
+	}
+	percentiles("search", det, capped);
+	percentiles("searchRestarts", rnd, 0);
+}
+
+/*
+ * Run mode on problem p, false if there is no such problem.
+ */
+template <class Traits>
+static bool run(const string &mode, const string &p, int a, int b, int c) {
+	Counter<Traits> s;
+	double t = now();
+	if(!build(s, p, a, b, c))
+		return false;
+	double built = now() - t;
+	if(mode == "first") {
+		Rows m;
+		build(m, p, a, b, c);
+		cout << p << ": " << m.r.size() << " rows, " << trials << " trials\n";
+		first<Traits>(m);
+		return true;
+	}
+	if(mode == "prefetch") {
+		cout << p << ": " << s.rowCount() << " rows, built in " << built << " s\n";
+		prefetch(s);
+		return true;
+	}
+	if(mode == "sample") {
+		cout << p << ": " << s.rowCount() << " rows, built in " << built << " s\n";
+		sample(s);
+		return true;
+	}
+	t = now();
+	unsigned long n = s.count();
+	t = now() - t;
+	cout << p << ": " << s.rowCount() << " rows, " << n << " solutions, built in "
+	     << built << " s, solved in " << t << " s\n";
+	return true;
+}
+
+int main(int argc, char **argv) {
+	int i = 1;
+	bool trail = argc > i && string(argv[i]) == "trail";
+	i += trail;
+	string mode = argc > i && (string(argv[i]) == "sample" || string(argv[i]) == "first" || string(argv[i]) == "prefetch") ? argv[i++] : "count";
+	string p = argc > i ? argv[i] : "";
+	int a = argc > i+1 ? atoi(argv[i+1]) : 0;
+	int b = argc > i+2 ? atoi(argv[i+2]) : 0;
+	int c = argc > i+3 ? atoi(argv[i+3]) : 0;
+	if(!(trail ? run<dlx::trailTraits>(mode, p, a, b, c) : run<dlx::traits<> >(mode, p, a, b, c))) {
+		cerr << "usage: " << argv[0] << " [trail] [sample | first | prefetch] queens N | langford N | pentominoes W H | soma | random R C K\n";
+		return 1;
+	}
+
+	return 0;
+}
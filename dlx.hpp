@@ -1,238 +1,3591 @@
 #include <iostream>
 #include <vector>
 #include <iterator>
+#include <algorithm>
+#include <climits>
+#include <limits>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <new>
+#include <stdexcept>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DLX_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+#if defined(__GNUC__) && !defined(DLX_NO_PREFETCH)
+#define DLX_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define DLX_PREFETCH(p)
+#endif
 
 using namespace std;
 
 namespace kpfp {
 	namespace dlx {
 
-		struct header;
+		/**
+		 * Header structure.
+		 * Holds the cold part of a column, its name, in an array of its own.
+		 * The hot part (the ring of active columns and the sizes) lives in dense
+		 * arrays of dlxSolver, and the vertical list is closed by a head node,
+		 * so neither search nor column selection touches headers.
+		 * Take a note, that for performance reasons, no constructor is given, thus
+		 * all members take default values.
+		 *
+		 * @tparam Name Column name type.
+		 */
+		template <class Name>
+		struct basicHeader {
+			Name N; /**< Name of current header */
+		};
+
+		/**
+		 * Node structure of pointerLinks.
+		 * Take a note, that for performance reasons, no constructor is given, thus
+		 * all members take default values.
+		 *
+		 * @tparam Name Column name type of the header.
+		 * @tparam Index Column number type.
+		 */
+		template <class Name, class Index>
+		struct basicNode {
+			basicNode *L; /**< Node to the left */
+			basicNode *R; /**< Node to the right */
+			basicNode *U; /**< Node above */
+			basicNode *D; /**< Node below */
+			basicHeader<Name> *C; /**< Link to the current column's header */
+			Index X; /**< Number of the current column, for the hot column arrays */
+		};
+
+		/**
+		 * Node structure of offsetLinks.
+		 * Links are indices into the node arena.
+		 *
+		 * @tparam Index Column number type.
+		 * @tparam Offset Link type.
+		 */
+		template <class Index, class Offset>
+		struct offsetNode {
+			Offset L; /**< Node to the left */
+			Offset R; /**< Node to the right */
+			Offset U; /**< Node above */
+			Offset D; /**< Node below */
+			Index X; /**< Number of the current column; its header is h[X] */
+		};
+
+		/**
+		 * Link policy: nodes point at each other (the default). A node holds
+		 * its four neighbours, a pointer to its column's header (so that
+		 * n->C->N names the column) and the column number; every link is
+		 * translated whenever the arena moves (growth, copy, load elsewhere).
+		 */
+		struct pointerLinks {
+			/**
+			 * Node type and link operations for given name and index types.
+			 */
+			template <class Name, class Index>
+			struct bind {
+				typedef basicNode<Name, Index> node; /**< Node type */
+				typedef node *link; /**< Link type; NULL is no node */
+				static const bool stable = false; /**< Links survive arena moves */
+				static const std::size_t last = ~static_cast<std::size_t>(0); /**< Greatest arena index a link can hold */
+
+				static node &at(node *, link l) { return *l; }
+				static link make(node *base, std::size_t i) { return base + i; }
+				static std::size_t index(const node *base, link l) { // on addresses, base may be freed already
+					return (reinterpret_cast<std::size_t>(l) - reinterpret_cast<std::size_t>(base)) / sizeof(node);
+				}
+				static void setHeader(node &n, basicHeader<Name> *c) { n.C = c; }
+			};
+			static const unsigned int width = 0; /**< Bytes per stored link, 0 for pointers */
+		};
+
+		/**
+		 * Link policy: nodes hold arena indices of their neighbours in an
+		 * unsigned type of any width, and their column only by number (its
+		 * header is h[X]). Links survive arena moves untouched, and 16-bit
+		 * ones shrink a node to a fifth of the pointer one, but the arena,
+		 * column heads included, must fit the range of Offset; adding nodes
+		 * past it throws std::length_error. Every link is scaled by the node
+		 * size, so a matrix that fits in cache either way searches somewhat
+		 * slower than with pointers.
+		 *
+		 * @tparam Offset Unsigned integer type of links.
+		 */
+		template <class Offset>
+		struct offsetLinks {
+			/**
+			 * Node type and link operations for given name and index types.
+			 */
+			template <class Name, class Index>
+			struct bind {
+				typedef offsetNode<Index, Offset> node; /**< Node type */
+				typedef Offset link; /**< Link type; 0, the master head, is no node */
+				static const bool stable = true; /**< Links survive arena moves */
+				static const std::size_t last = static_cast<Offset>(~static_cast<Offset>(0)); /**< Greatest arena index a link can hold */
+
+				static node &at(node *base, link l) { return base[l]; }
+				static link make(node *, std::size_t i) { return static_cast<link>(i); }
+				static std::size_t index(const node *, link l) { return l; }
+				static void setHeader(node &, basicHeader<Name> *) {}
+			};
+			static const unsigned int width = sizeof(Offset); /**< Bytes per stored link, 0 for pointers */
+		};
+
+		/**
+		 * Policies of dlxSolver.
+		 * Chosen at compile time, so they cost nothing at run time. The types
+		 * set the range of column numbers, sizes and names, i.e. the element
+		 * types of the column arrays CL, CR, S, A and h and of the column
+		 * number in a node; wide ones lift the limits for huge instances.
+		 * The link policy sets the layout of the matrix: pointer nodes take
+		 * 48 bytes on a 64-bit machine, offsetLinks<unsigned short> ones with
+		 * 16-bit column numbers 10 bytes.
+		 * Column selection is vectorized for int sizes only; any other Size
+		 * falls back to a portable scan.
+		 *
+		 * @tparam Index Column numbers (addRow arguments and the ring of active columns).
+		 * @tparam Size Column sizes, signed.
+		 * @tparam Name Column names (header::N).
+		 * @tparam Trail How uncover restores links: false walks the column again
+		 * 		   like cover did (dancing links), true pops the nodes cover
+		 * 		   removed off a trail, a flat array walk.
+		 * @tparam Links Link policy, pointerLinks or offsetLinks.
+		 */
+		template <class Index = unsigned int, class Size = int, class Name = int, bool Trail = false, class Links = pointerLinks>
+		struct traits {
+			typedef Index index_type; /**< Column number type */
+			typedef Size size_type; /**< Column size type */
+			typedef Name name_type; /**< Column name type */
+			static const bool trail = Trail; /**< Undo by trail */
+			typedef Links links; /**< Link policy */
+		};
+
+		typedef traits<unsigned long, long, unsigned long> wideTraits; /**< Everything as wide as a pointer */
+		typedef traits<unsigned int, int, int, true> trailTraits; /**< Default types, undo by trail */
+		typedef traits<unsigned short, int, unsigned short, false, offsetLinks<unsigned short> > compactTraits; /**< 10-byte nodes: up to 65535 columns and nodes, column heads included */
+
+		typedef basicNode<int, unsigned int> node; /**< Node of a solver with default traits */
+		typedef basicHeader<int> header; /**< Header of a solver with default traits */
+
+		/**
+		 * Arena size (in nodes) from which cover and uncover prefetch the links
+		 * of the next row. Smaller matrices stay in cache, where the extra
+		 * walk over every row costs more than it saves. A solver takes it as
+		 * its prefetchFrom, which Derived may change (bench compares both).
+		 */
+		const std::size_t prefetchNodes = 1 << 18;
+
+		/**
+		 * Growable array of plain structs, a stand-in for std::vector that can
+		 * also live in a private file mapping (see dlxSolver::load). A mapped
+		 * array is used in place; writes go to private copies of the pages
+		 * touched. Growing past its size moves it to the heap.
+		 * Elements are copied bytewise and never constructed or destroyed.
+		 *
+		 * @tparam T Element type, a POD struct.
+		 */
+		template <class T>
+		class arena {
+			T *p; /**< Elements */
+			std::size_t n; /**< Size */
+			std::size_t cap; /**< Capacity */
+			std::size_t mapped; /**< Length of the mapping p points to, 0 if p is on the heap */
+
+			/**
+			 * Give back the storage.
+			 */
+			void release() {
+				if(mapped)
+					munmap(p, mapped);
+				else
+					std::free(p);
+			}
+		public:
+			typedef T *iterator; /**< Iterator */
+			typedef const T *const_iterator; /**< Constant iterator */
+
+			arena() : p(0), n(0), cap(0), mapped(0) {}
+			arena(const arena &a) : p(0), n(0), cap(0), mapped(0) { assign(a.begin(), a.end()); }
+			arena &operator=(const arena &a) {
+				arena t(a);
+				swap(t);
+				return *this;
+			}
+#if __cplusplus >= 201103L
+			arena(arena &&a) : p(a.p), n(a.n), cap(a.cap), mapped(a.mapped) {
+				a.p = 0;
+				a.n = a.cap = a.mapped = 0;
+			}
+#endif
+			~arena() { release(); }
+
+			std::size_t size() const { return n; }
+			std::size_t capacity() const { return cap; }
+			bool empty() const { return n == 0; }
+			T &operator[](std::size_t i) { return p[i]; }
+			const T &operator[](std::size_t i) const { return p[i]; }
+			T &back() { return p[n-1]; }
+			iterator begin() { return p; }
+			iterator end() { return p + n; }
+			const_iterator begin() const { return p; }
+			const_iterator end() const { return p + n; }
+
+			/**
+			 * Move to a heap block of at least m elements.
+			 *
+			 * @param m Capacity
+			 */
+			void reserve(std::size_t m) {
+				if(m <= cap)
+					return;
+				T *q = static_cast<T*>(std::malloc(m * sizeof(T)));
+				if(!q)
+					throw std::bad_alloc();
+				if(n)
+					std::memcpy(q, p, n * sizeof(T));
+				release();
+				p = q;
+				cap = m;
+				mapped = 0;
+			}
+			void resize(std::size_t m) {
+				reserve(m);
+				for(; n<m; ++n)
+					p[n] = T();
+				n = m;
+			}
+
+			/**
+			 * Grow to m elements without initialising the new ones, so that
+			 * the caller (e.g. several threads, each its own slice) is the
+			 * first to touch their pages.
+			 *
+			 * @param m Size, not less than the current one.
+			 */
+			void extend(std::size_t m) {
+				reserve(m);
+				n = m;
+			}
+			void push_back(const T &x) {
+				if(n == cap)
+					reserve(cap ? 2*cap : 16);
+				p[n++] = x;
+			}
+			void assign(const_iterator first, const_iterator last) {
+				n = 0;
+				reserve(last - first);
+				if(first != last)
+					std::memcpy(p, first, (last - first) * sizeof(T));
+				n = last - first;
+			}
+			void clear() { n = 0; }
+			void swap(arena &a) {
+				std::swap(p, a.p);
+				std::swap(n, a.n);
+				std::swap(cap, a.cap);
+				std::swap(mapped, a.mapped);
+			}
+
+			/**
+			 * Replace contents with m elements mapped privately from a file.
+			 *
+			 * @param fd File
+			 * @param off Offset of the first element, a multiple of the page size.
+			 * @param m Number of elements
+			 * @param hint Preferred address of the first element
+			 * @return false if mapping failed (contents are then unchanged).
+			 */
+			bool map(int fd, std::size_t off, std::size_t m, void *hint) {
+				std::size_t len = m * sizeof(T);
+				if(len == 0)
+					len = 1;
+				void *q = MAP_FAILED;
+#ifdef MAP_FIXED_NOREPLACE
+				q = mmap(hint, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED_NOREPLACE, fd, off);
+#endif
+				if(q == MAP_FAILED)
+					q = mmap(hint, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, off);
+				if(q == MAP_FAILED)
+					return false;
+				release();
+				p = static_cast<T*>(q);
+				n = cap = m;
+				mapped = len;
+				return true;
+			}
+		};
+
+		/**
+		 * Column-selection kernel.
+		 * Finds the first column c in [1; n) with A[c] == 0 and the smallest S[c].
+		 *
+		 * @param S Column sizes
+		 * @param A Active mask, 0 for active primary columns; A[0] is never 0
+		 * @param n Number of columns (including master header)
+		 * @return Column index, 0 if no column is active.
+		 */
+		typedef unsigned int (*minColumnFn)(const int *S, const int *A, unsigned int n);
+
+		/**
+		 * Portable column-selection kernel.
+		 * @see minColumnFn
+		 */
+		inline unsigned int minColumnScalar(const int *S, const int *A, unsigned int n) {
+			unsigned int c = 0;
+			int s = INT_MAX;
+			for(unsigned int i=1; i<n; ++i) {
+				if(A[i] == 0 && S[i] < s) {
+					s = S[i];
+					c = i;
+				}
+			}
+			return c;
+		}
+
+#ifdef DLX_X86_KERNELS
+		/**
+		 * AVX2 column-selection kernel, 8 columns per step.
+		 * @see minColumnFn
+		 */
+		__attribute__((target("avx2")))
+		inline unsigned int minColumnAVX2(const int *S, const int *A, unsigned int n) {
+			const __m256i big = _mm256_set1_epi32(INT_MAX);
+			const __m256i eight = _mm256_set1_epi32(8);
+			__m256i minv = big;
+			__m256i mini = _mm256_setzero_si256();
+			__m256i cur = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+			unsigned int i = 0;
+			for(; i+8<=n; i+=8) {
+				__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(A + i));
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(S + i));
+				v = _mm256_blendv_epi8(big, v, _mm256_cmpeq_epi32(a, _mm256_setzero_si256()));
+				__m256i lt = _mm256_cmpgt_epi32(minv, v);
+				minv = _mm256_blendv_epi8(minv, v, lt);
+				mini = _mm256_blendv_epi8(mini, cur, lt);
+				cur = _mm256_add_epi32(cur, eight);
+			}
+			int sv[8], si[8];
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(sv), minv);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(si), mini);
+			unsigned int c = 0;
+			int s = INT_MAX;
+			for(unsigned int l=0; l<8; ++l) {
+				if(sv[l] < s || (sv[l] == s && sv[l] != INT_MAX && static_cast<unsigned int>(si[l]) < c)) {
+					s = sv[l];
+					c = si[l];
+				}
+			}
+			for(; i<n; ++i) {
+				if(A[i] == 0 && S[i] < s) {
+					s = S[i];
+					c = i;
+				}
+			}
+			return c;
+		}
+
+		/**
+		 * AVX-512 column-selection kernel, 16 columns per step.
+		 * @see minColumnFn
+		 */
+		__attribute__((target("avx512f")))
+		inline unsigned int minColumnAVX512(const int *S, const int *A, unsigned int n) {
+			const __m512i zero = _mm512_setzero_si512();
+			const __m512i sixteen = _mm512_set1_epi32(16);
+			__m512i minv = _mm512_set1_epi32(INT_MAX);
+			__m512i mini = zero;
+			__m512i cur = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+			unsigned int i = 0;
+			for(; i+16<=n; i+=16) {
+				__mmask16 m = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(A + i), zero);
+				__m512i v = _mm512_loadu_si512(S + i);
+				__mmask16 lt = _mm512_mask_cmplt_epi32_mask(m, v, minv);
+				minv = _mm512_mask_mov_epi32(minv, lt, v);
+				mini = _mm512_mask_mov_epi32(mini, lt, cur);
+				cur = _mm512_add_epi32(cur, sixteen);
+			}
+			int sv[16], si[16];
+			_mm512_storeu_si512(sv, minv);
+			_mm512_storeu_si512(si, mini);
+			unsigned int c = 0;
+			int s = INT_MAX;
+			for(unsigned int l=0; l<16; ++l) {
+				if(sv[l] < s || (sv[l] == s && sv[l] != INT_MAX && static_cast<unsigned int>(si[l]) < c)) {
+					s = sv[l];
+					c = si[l];
+				}
+			}
+			for(; i<n; ++i) {
+				if(A[i] == 0 && S[i] < s) {
+					s = S[i];
+					c = i;
+				}
+			}
+			return c;
+		}
+#endif
+
+		/**
+		 * Best column-selection kernel supported by the running CPU.
+		 */
+		inline minColumnFn minColumnKernel() {
+#ifdef DLX_X86_KERNELS
+			__builtin_cpu_init();
+			if(__builtin_cpu_supports("avx512f"))
+				return minColumnAVX512;
+			if(__builtin_cpu_supports("avx2"))
+				return minColumnAVX2;
+#endif
+			return minColumnScalar;
+		}
+
+		/**
+		 * Run column-selection kernel on int arrays.
+		 * @see minColumnFn
+		 */
+		inline unsigned int minColumn(minColumnFn f, const int *S, const int *A, unsigned int n) {
+			return f(S, A, n);
+		}
+
+		/**
+		 * Column selection for other size types: portable scan.
+		 * @see minColumnFn
+		 */
+		template <class Size>
+		unsigned int minColumn(minColumnFn, const Size *S, const Size *A, unsigned int n) {
+			unsigned int c = 0;
+			for(unsigned int i=1; i<n; ++i) {
+				if(A[i] == 0 && (c == 0 || S[i] < S[c]))
+					c = i;
+			}
+			return c;
+		}
+
+		/**
+		 * Set of covered columns.
+		 * Identifies a residual subproblem: rows still present in the matrix are
+		 * exactly those that do not intersect any covered column. Besides the bits
+		 * it keeps a Zobrist-style hash that is updated in O(1) on every flip.
+		 */
+		struct columnSet {
+			enum { B = sizeof(unsigned long) * CHAR_BIT }; /**< Bits per word */
+			std::vector<unsigned long> w; /**< Bits, column c is bit c%B of w[c/B] */
+			unsigned long hash; /**< XOR of mix(c) over all covered columns c */
+
+			/**
+			 * Constructor.
+			 *
+			 * @param n Number of columns (including master header).
+			 */
+			explicit columnSet(std::size_t n=0) : w((n + B - 1) / B, 0UL), hash(0UL) {}
+
+			/**
+			 * Scrambles column number into a hash value.
+			 *
+			 * @param c Column
+			 */
+			static unsigned long mix(unsigned long c) {
+				c = (c ^ (c >> 16)) * 0x45d9f3bUL;
+				c = (c ^ (c >> 16)) * 0x45d9f3bUL;
+				return c ^ (c >> 16) ^ (c << (B / 2));
+			}
+
+			/**
+			 * Toggle column c.
+			 *
+			 * @param c Column
+			 */
+			void flip(unsigned int c) {
+				w[c / B] ^= 1UL << (c % B);
+				hash ^= mix(c);
+			}
+		};
+
+		/**
+		 * New matrix generation, unique within the process.
+		 * Tags a matrix state so that caches computed on it can tell when it
+		 * has been edited.
+		 */
+		inline unsigned long nextGeneration() {
+			static unsigned long g = 0;
+			return __sync_add_and_fetch(&g, 1UL);
+		}
+
+		/**
+		 * Transposition table for residual subproblems.
+		 * Stores solution counts, or any other per-subproblem value (e.g. ZDD
+		 * vertices). Memory use is bounded by the budget given at construction. The table is
+		 * split into buckets of a few slots each; when a bucket is full, the entry
+		 * whose subtree took the least work to count is evicted.
+		 * Entries describe one matrix only. A cache kept across calls must be
+		 * bound to the generation of the matrix it is used on (see bind); every
+		 * edit of a solver's matrix takes a new generation, so stale entries are
+		 * dropped instead of being trusted.
+		 */
+		class countCache {
+			std::size_t budget; /**< Memory budget in bytes */
+			unsigned long gen; /**< Matrix generation the entries belong to, 0 if unbound */
+			std::size_t W; /**< Words per key */
+			std::size_t n; /**< Number of buckets */
+			std::vector<unsigned long> K; /**< Keys, W words per slot */
+			std::vector<unsigned long> V; /**< Counts */
+			std::vector<unsigned long> C; /**< Work spent on each entry, 0 for empty slot */
+
+			/**
+			 * Size the table for keys of given width, dropping all entries.
+			 *
+			 * @param words Words per key
+			 */
+			void init(std::size_t words) {
+				W = words;
+				n = budget / ((W + 2) * sizeof(unsigned long) * ways);
+				K.assign(n * ways * W, 0UL);
+				V.assign(n * ways, 0UL);
+				C.assign(n * ways, 0UL);
+			}
+		public:
+			enum { ways = 4 }; /**< Slots per bucket */
+			unsigned long hits; /**< Successful lookups */
+			unsigned long misses; /**< Failed lookups */
+
+			/**
+			 * Constructor.
+			 * The table is allocated on first use, when the key width is known.
+			 *
+			 * @param budget Memory budget in bytes
+			 */
+			explicit countCache(std::size_t budget) : budget(budget), gen(0), W(0), n(0), hits(0), misses(0) {}
+
+			/**
+			 * Bind to a matrix generation, dropping all entries if it differs
+			 * from the one they were computed for.
+			 *
+			 * @param g Matrix generation, see nextGeneration
+			 */
+			void bind(unsigned long g) {
+				if(g == gen)
+					return;
+				gen = g;
+				C.assign(C.size(), 0UL);
+			}
+
+			/**
+			 * Look up a subproblem.
+			 *
+			 * @param k Covered columns
+			 * @param v Set to the cached count on success
+			 * @return Whether the key was found
+			 */
+			bool find(const columnSet &k, unsigned long &v) {
+				if(W != k.w.size())
+					init(k.w.size());
+				if(!n)
+					return false;
+				std::size_t b = (k.hash % n) * ways;
+				for(std::size_t i=b; i<b+ways; ++i) {
+					if(C[i] && std::equal(k.w.begin(), k.w.end(), K.begin() + i*W)) {
+						v = V[i];
+						++hits;
+						return true;
+					}
+				}
+				++misses;
+				return false;
+			}
+
+			/**
+			 * Store a subproblem value.
+			 *
+			 * @param k Covered columns
+			 * @param v Number of solutions (or other value)
+			 * @param work Search nodes it took to compute v (at least 1)
+			 */
+			void insert(const columnSet &k, unsigned long v, unsigned long work) {
+				if(W != k.w.size())
+					init(k.w.size());
+				if(!n)
+					return;
+				std::size_t b = (k.hash % n) * ways;
+				std::size_t victim = b;
+				for(std::size_t i=b; i<b+ways; ++i) {
+					if(C[i] < C[victim])
+						victim = i;
+				}
+				if(C[victim] > work)
+					return;
+				std::copy(k.w.begin(), k.w.end(), K.begin() + victim*W);
+				V[victim] = v;
+				C[victim] = work;
+			}
+		};
+
+		/**
+		 * Pseudo-random number generator (xorshift64*).
+		 * Small and fast; good enough for sampling and tie-breaking.
+		 */
+		struct rng {
+			unsigned long x; /**< State, never 0 */
+
+			/**
+			 * Constructor.
+			 *
+			 * @param seed Any value
+			 */
+			explicit rng(unsigned long seed=1) : x(columnSet::mix(seed) | 1UL) {}
+
+			/**
+			 * Next raw value.
+			 */
+			unsigned long operator()() {
+				x ^= x >> 12;
+				x ^= x << 25;
+				x ^= x >> 27;
+				return x * 2685821657736338717UL;
+			}
+
+			/**
+			 * Uniform value in range [0; n).
+			 *
+			 * @param n Upper bound, n > 0
+			 */
+			unsigned long below(unsigned long n) {
+				unsigned long lim = ULONG_MAX - ULONG_MAX % n;
+				unsigned long v;
+				do {
+					v = (*this)();
+				} while(v >= lim);
+				return v % n;
+			}
+		};
+
+		/**
+		 * Restart schedule.
+		 * Gives the node budget of the i-th run of a restarting search: either
+		 * unit times the Luby sequence (1, 1, 2, 1, 1, 2, 4, ...), or unit times
+		 * factor^i.
+		 */
+		struct schedule {
+			enum kind { luby, geometric };
+			kind K; /**< Kind of schedule */
+			unsigned long unit; /**< Budget of the first run */
+			unsigned int factor; /**< Growth factor of geometric schedule */
+
+			/**
+			 * Constructor.
+			 *
+			 * @param k Kind of schedule
+			 * @param unit Budget unit (search nodes)
+			 * @param factor Growth factor, used by geometric schedule only
+			 */
+			schedule(kind k=luby, unsigned long unit=1024, unsigned int factor=2) : K(k), unit(unit), factor(factor) {}
+
+			/**
+			 * Node budget of i-th run (i = 0, 1, ...), saturated at ULONG_MAX.
+			 *
+			 * @param i Run number
+			 */
+			unsigned long operator()(unsigned int i) const {
+				unsigned long m = 1;
+				if(K == geometric) {
+					while(i-- && m <= ULONG_MAX / factor)
+						m *= factor;
+				} else {
+					unsigned long j = i + 1;
+					for(;;) {
+						unsigned int k = 1;
+						while(k < sizeof(unsigned long) * CHAR_BIT && (1UL << k) - 1 < j)
+							++k;
+						if(j >= (1UL << k) - 1) {
+							m = 1UL << (k - 1);
+							break;
+						}
+						j -= (1UL << (k - 1)) - 1;
+					}
+				}
+				return m <= ULONG_MAX / unit ? m * unit : ULONG_MAX;
+			}
+		};
+
+		/**
+		 * Zero-suppressed decision diagram of a family of exact covers.
+		 * Built by dlxSolver::compile. Every vertex is labeled with the number of
+		 * the chosen row; its HI branch selects the row, LO skips it. Vertices are
+		 * shared through a unique table and stored in topological order
+		 * (children first), vertex 0 is the empty family and 1 is {{}}.
+		 * Labels are row numbers rather than nodes, so a diagram stays valid
+		 * after its solver grows, relocates, is copied or is destroyed.
+		 */
+		class zdd {
+		public:
+			/**
+			 * Vertex structure.
+			 */
+			struct vertex {
+				unsigned int V; /**< Row this vertex decides */
+				unsigned long LO; /**< Row not taken */
+				unsigned long HI; /**< Row taken */
+			};
+		private:
+			std::vector<vertex> v; /**< Vertices, v[0] and v[1] are terminals */
+			std::vector<unsigned long> T; /**< Unique table, open addressing, 0 = empty */
+			std::vector<unsigned long> cnt; /**< Path counts, filled lazily by count() */
+
+			static std::size_t hash(unsigned int p, unsigned long lo, unsigned long hi) {
+				return columnSet::mix(p ^ columnSet::mix(lo ^ columnSet::mix(hi)));
+			}
+
+			void grow() {
+				std::vector<unsigned long> t(T.empty() ? 1024 : 2*T.size(), 0UL);
+				for(std::size_t i=2; i<v.size(); ++i) {
+					std::size_t j = hash(v[i].V, v[i].LO, v[i].HI) & (t.size() - 1);
+					while(t[j])
+						j = (j + 1) & (t.size() - 1);
+					t[j] = i;
+				}
+				T.swap(t);
+			}
+		public:
+			enum { bottom = 0, top = 1 };
+			unsigned long root; /**< Root vertex */
+
+			/**
+			 * Constructor. Creates empty family.
+			 */
+			zdd() : v(2), root(bottom) {
+				v[0].V = v[1].V = 0;
+				v[0].LO = v[0].HI = v[1].LO = v[1].HI = 0;
+			}
+
+			/**
+			 * Number of vertices (including terminals).
+			 */
+			std::size_t size() const { return v.size(); }
+
+			/**
+			 * Get vertex.
+			 *
+			 * @param i Vertex number
+			 */
+			const vertex &operator[](unsigned long i) const { return v[i]; }
+
+			/**
+			 * Find or create vertex.
+			 * Applies zero-suppression rule: returns lo if hi is the empty family.
+			 *
+			 * @param p Row number
+			 * @param lo LO child
+			 * @param hi HI child
+			 * @return Vertex number
+			 */
+			unsigned long make(unsigned int p, unsigned long lo, unsigned long hi) {
+				if(hi == bottom)
+					return lo;
+				if(2*v.size() >= T.size())
+					grow();
+				std::size_t j = hash(p, lo, hi) & (T.size() - 1);
+				for(; T[j]; j = (j + 1) & (T.size() - 1)) {
+					const vertex &x = v[T[j]];
+					if(x.V == p && x.LO == lo && x.HI == hi)
+						return T[j];
+				}
+				vertex x;
+				x.V = p;
+				x.LO = lo;
+				x.HI = hi;
+				T[j] = v.size();
+				v.push_back(x);
+				return T[j];
+			}
+
+			/**
+			 * Number of solutions below vertex i.
+			 * Counts wrap around past ULONG_MAX.
+			 *
+			 * @param i Vertex number
+			 */
+			unsigned long count(unsigned long i) {
+				if(cnt.size() < v.size()) {
+					std::size_t k = cnt.size();
+					cnt.resize(v.size());
+					if(k == 0) {
+						cnt[bottom] = 0;
+						cnt[top] = 1;
+						k = 2;
+					}
+					for(; k<v.size(); ++k)
+						cnt[k] = cnt[v[k].LO] + cnt[v[k].HI];
+				}
+				return cnt[i];
+			}
+
+			/**
+			 * Number of solutions.
+			 */
+			unsigned long count() { return count(root); }
+
+			/**
+			 * Draw a uniformly random solution.
+			 *
+			 * @param g Random number generator
+			 * @param out Receives the numbers of the selected rows
+			 * @return false if there are no solutions
+			 */
+			bool sample(rng &g, std::vector<unsigned int> &out) {
+				out.clear();
+				unsigned long i = root;
+				if(count(i) == 0)
+					return false;
+				while(i != top) {
+					if(g.below(count(i)) < count(v[i].HI)) {
+						out.push_back(v[i].V);
+						i = v[i].HI;
+					} else {
+						i = v[i].LO;
+					}
+				}
+				return true;
+			}
+
+			/**
+			 * Stream all solutions.
+			 * Solutions come in the order search() would find them.
+			 *
+			 * @tparam Visitor Callable as f(const std::vector<unsigned int> &rows).
+			 * @param f Called once per solution
+			 */
+			template <class Visitor>
+			void enumerate(Visitor &f) const {
+				std::vector<unsigned int> rows;
+				std::vector<unsigned long> stack; /* vertices whose HI branch was taken */
+				unsigned long i = root;
+				for(;;) {
+					// descend along HI edges as far as possible
+					while(i > top) {
+						stack.push_back(i);
+						rows.push_back(v[i].V);
+						i = v[i].HI;
+					}
+					if(i == top)
+						f(static_cast<const std::vector<unsigned int>&>(rows));
+					// backtrack to the deepest vertex whose LO branch is still open
+					do {
+						if(stack.empty())
+							return;
+						i = v[stack.back()].LO;
+						stack.pop_back();
+						rows.pop_back();
+					} while(i == bottom);
+				}
+			}
+		};
+
+		/**
+		 * Query for search under assumptions: rows to force and rows to exclude.
+		 */
+		struct query {
+			std::vector<unsigned int> force; /**< Rows every solution must contain */
+			std::vector<unsigned int> exclude; /**< Rows no solution may contain */
+		};
+
+		/**
+		 * Header of a solver image (see dlxSolver::save).
+		 * Offsets are in bytes from the start of the file.
+		 */
+		struct imageHeader {
+			char magic[8]; /**< "DLXIMG3" */
+			unsigned long layout[6]; /**< Sizes of node, header, index, size and name types, and of links (0 for pointers) */
+			unsigned long base; /**< Address the pointer links in the file assume it is mapped at */
+			unsigned long columns; /**< Headers (and column heads), master included */
+			unsigned long heads; /**< Arena slots for column heads; rows start there */
+			unsigned long nodes; /**< Nodes, column heads included */
+			unsigned long rows; /**< Rows */
+			unsigned long active; /**< Uncovered primary columns */
+			unsigned long off[8]; /**< Sections: headers, nodes, CL, CR, S, A, first node of each row, row states */
+			unsigned long size; /**< File length */
+		};
+
+		const unsigned long imageAlign = 1UL << 16; /**< Alignment of image sections, a multiple of the page size */
+#if defined(__LP64__) || defined(_LP64)
+		const unsigned long imageBase = 0x3d0000000000UL; /**< Default preferred address of an image */
+#else
+		const unsigned long imageBase = 0; /**< Default preferred address of an image (none) */
+#endif
+
+		/**
+		 * Append to an image file, after padding it with zeros up to a given offset.
+		 *
+		 * @param f File
+		 * @param pos Bytes written so far, updated.
+		 * @param at Offset to write at, not less than pos.
+		 * @param p Data
+		 * @param n Length of data
+		 * @return false on I/O error.
+		 */
+		inline bool imageWrite(FILE *f, unsigned long &pos, unsigned long at, const void *p, std::size_t n) {
+			static const char zero[256] = { 0 };
+			while(pos < at) {
+				std::size_t k = std::min<unsigned long>(at - pos, sizeof(zero));
+				if(std::fwrite(zero, 1, k, f) != k)
+					return false;
+				pos += k;
+			}
+			if(n && std::fwrite(p, 1, n, f) != n)
+				return false;
+			pos += n;
+			return true;
+		}
+
+		/**
+		 * Lay out the sections of an image: compute off[] and size of a header
+		 * from its layout and counts. save() writes exactly this layout, and
+		 * load() accepts only files that match it.
+		 *
+		 * @param ih Header; layout, columns, nodes and rows are read, off and size set.
+		 */
+		inline void imageLayout(imageHeader &ih) {
+			const unsigned long len[8] = {
+				ih.columns * ih.layout[1], ih.nodes * ih.layout[0],
+				ih.columns * ih.layout[2], ih.columns * ih.layout[2],
+				ih.columns * ih.layout[3], ih.columns * ih.layout[3],
+				ih.rows * sizeof(unsigned long), ih.rows
+			};
+			unsigned long o = sizeof(ih);
+			for(int i=0; i<8; ++i) {
+				o = (o + imageAlign - 1) / imageAlign * imageAlign;
+				ih.off[i] = o;
+				o += len[i];
+			}
+			ih.size = o;
+		}
+
+		/**
+		 * Read from an image file.
+		 *
+		 * @param fd File
+		 * @param off Offset
+		 * @param p Buffer
+		 * @param n Length
+		 * @return false on I/O error or end of file.
+		 */
+		inline bool imageRead(int fd, unsigned long off, void *p, std::size_t n) {
+			char *q = static_cast<char*>(p);
+			while(n) {
+				ssize_t k = pread(fd, q, n, off);
+				if(k <= 0)
+					return false;
+				q += k;
+				off += k;
+				n -= k;
+			}
+			return true;
+		}
+	}
+
+	/**
+	 * Solves generalized exact cover problem using DLX algorithm.
+	 * Single-threaded.
+	 *
+	 * @tparam Derived Static polymorphism via CRTP. Used to return results
+	 * 		   to user-defined functions.
+	 * @tparam Traits Type policies, see dlx::traits.
+	 */
+	template <class Derived, class Traits = dlx::traits<> >
+	class dlxSolver {
+	public:
+		typedef typename Traits::index_type index_type; /**< Column number type */
+		typedef typename Traits::size_type size_type; /**< Column size type */
+		typedef typename Traits::name_type name_type; /**< Column name type */
+		typedef typename Traits::links::template bind<name_type, index_type> linker; /**< Operations of the link policy */
+		typedef typename linker::node node; /**< Node type */
+		typedef typename linker::link link; /**< Link to a node, see at() */
+		typedef dlx::basicHeader<name_type> header; /**< Header type */
+		typedef dlx::zdd zdd; /**< Diagram type, see compile */
+
+		/**
+		 * Row states.
+		 */
+		enum rowState {
+			enabled, /**< Linked into its columns */
+			disabled, /**< Temporarily unlinked from its columns */
+			removed /**< Deleted for good */
+		};
+	protected:
+		dlx::arena<header> h; /**< Headers, i.e. cold column names. h[0] is master header. */
+		std::vector<index_type> CL; /**< Column to the left in the ring of active primary columns; 0 is master */
+		std::vector<index_type> CR; /**< Column to the right in the ring of active primary columns */
+		std::vector<size_type> S; /**< Sizes, i.e. number of 1's in each column */
+		std::vector<size_type> A; /**< Active mask: 0 for uncovered primary columns, covering depth otherwise */
+		index_type active; /**< Number of uncovered primary columns */
+		dlx::minColumnFn kernel; /**< Column-selection kernel */
+		std::size_t prefetchFrom; /**< Arena size from which cover and uncover prefetch, dlx::prefetchNodes unless Derived sets it */
+		std::vector<link> O; /**< Result vector. */
+		std::vector<link> rows; /**< Some node of every row, by row number; no node (NULL or 0) for removed and empty rows */
+		std::vector<unsigned char> state; /**< State of every row */
+		std::vector<std::size_t> rowStart; /**< Arena index of the first node of every row, nondecreasing */
+		std::vector<double> weight; /**< Cost of every row for optimize(); empty until some row is given one, missing means 1 */
+		dlx::arena<node> nodes; /**< Node arena: column heads first (nodes[c] closes column c), then rows from nodes[heads] on, contiguous in order of addition */
+		std::size_t heads; /**< Arena slots reserved for column heads, h.size() of them in use */
+		bool halt; /**< Set by solution() to end the running search early; cleared when a search starts */
+		double incumbent; /**< Cost of the best solution found by optimize(), i.e. of the one solution() reports */
+		unsigned int rowsMin; /**< Fewest rows a solution reported by search may have */
+		unsigned int rowsMax; /**< Most rows a solution reported by search may have, 0 if unlimited */
+		std::vector<unsigned int> wide; /**< With rowsMax: most primary columns of a live row through each column, as the search started */
+		std::vector<link> trail; /**< With Traits::trail: nodes removed by cover, in order */
+		std::vector<std::size_t> marks; /**< With Traits::trail: trail length at each pending cover */
+		unsigned long generation; /**< Matrix generation, renewed by every edit; binds countCache contents */
+
+		/**
+		 * Link to the node at an arena index; for a column number, its head.
+		 *
+		 * @param i Arena index
+		 */
+		link linkAt(std::size_t i) { return linker::make(&nodes[0], i); }
+
+		/**
+		 * Make a column head an empty column: its links point to itself.
+		 *
+		 * @param c Column
+		 */
+		void initHead(std::size_t c) {
+			node &n = nodes[c];
+			n.L = n.R = n.U = n.D = linkAt(c);
+			linker::setHeader(n, &h[c]);
+			n.X = static_cast<index_type>(c);
+		}
+
+		/**
+		 * Translate every link after the node arena and/or the headers moved,
+		 * or after the rows moved up the arena. Links into the old arena are
+		 * moved to the same index in nodes, plus shift if the index is at
+		 * least from. Does nothing to offset links that keep their index.
+		 *
+		 * @param old Previous address of the node arena
+		 * @param from First arena index that moved up
+		 * @param shift Slots it moved up by
+		 */
+		void relocate(const node *old, std::size_t from=0, std::size_t shift=0);
+
+		/**
+		 * Move the node arena to a buffer of at least n nodes.
+		 *
+		 * @param n Capacity
+		 */
+		void growNodes(std::size_t n);
+
+		/**
+		 * Make room for n column heads at the front of the arena. Rows in the
+		 * arena are moved up. The room at least doubles (short links: it takes
+		 * at most half of the slots they can still reach, so rows keep room),
+		 * and so does the arena when it has to move, so that adding columns
+		 * one by one costs amortized constant time with or without rows.
+		 *
+		 * @param n Column heads, master included
+		 */
+		void growHeads(std::size_t n);
+
+		/**
+		 * Share of one thread in a parallel buildFromCSR.
+		 */
+		template <class Offset, class Index>
+		struct buildPart {
+			dlxSolver *s; /**< Solver being filled */
+			const std::vector<Offset> *off; /**< Row offsets */
+			const std::vector<Index> *col; /**< Column numbers */
+			std::size_t r0, r1; /**< Rows [r0; r1) of the input are ours */
+			std::size_t base; /**< Arena index of our first node */
+			std::size_t row0; /**< Row number of input row r0 */
+			std::size_t c0, c1; /**< Columns [c0; c1) are ours when stitching */
+			std::vector<link> top; /**< First node of our sublist of every column, or no node */
+			std::vector<link> bottom; /**< Last node of our sublist of every column */
+			std::vector<size_type> size; /**< Length of our sublist of every column */
+			std::vector<buildPart> *all; /**< Shares of all threads, in row order */
+			bool stitch; /**< Phase: false lays out rows, true stitches columns */
+		};
+
+		/**
+		 * Thread entry point of a parallel buildFromCSR.
+		 *
+		 * @param p Pointer to buildPart<Offset, Index>
+		 */
+		template <class Offset, class Index>
+		static void *buildRun(void *p);
+
+		/**
+		 * Append a zeroed node to the arena, growing it if needed.
+		 *
+		 * @return Arena index of the new node
+		 */
+		std::size_t newNode();
+
+		/**
+		 * Unlink every node of a row from its column.
+		 *
+		 * @param n Some node of the row
+		 */
+		void unlinkRow(link n);
+
+		/**
+		 * Undo unlinkRow.
+		 * Exact only if it is the last row unlinked and not yet restored.
+		 *
+		 * @param n The node given to unlinkRow
+		 */
+		void relinkRow(link n);
+
+		/**
+		 * Cover column c.
+		 *
+		 * @param c Column
+		 */
+		void cover(index_type c);
+
+		/**
+		 * Uncover column c.
+		 * Must undo the most recent cover that is still in effect.
+		 *
+		 * @param c Column
+		 */
+		void uncover(index_type c);
+
+		/**
+		 * Select column with the smallest number of 1s.
+		 * While many columns are active, a vectorized scan over the dense S and A
+		 * arrays is used; otherwise the ring of active columns is walked.
+		 *
+		 * @return First such column in the master header's ring.
+		 */
+		index_type chooseColumn();
+
+		/**
+		 * Select column with the smallest number of 1s, breaking ties at random.
+		 *
+		 * @param g Random number generator
+		 * @return Uniformly chosen one among such columns.
+		 */
+		index_type chooseColumn(dlx::rng &g);
+
+		/**
+		 * Counting variant of search.
+		 *
+		 * @param cache Transposition table or NULL
+		 * @param key Covered columns of the current subproblem
+		 * @param work Incremented by the number of search nodes visited
+		 * @return Number of solutions of the current subproblem
+		 */
+		unsigned long countSearch(dlx::countCache *cache, dlx::columnSet &key, unsigned long &work);
+
+		/**
+		 * Diagram-building variant of search.
+		 *
+		 * @param z Diagram being built
+		 * @param cache Memo of subproblem vertices or NULL
+		 * @param key Covered columns of the current subproblem
+		 * @param work Incremented by the number of search nodes visited
+		 * @return Vertex representing all solutions of the current subproblem
+		 */
+		unsigned long zddSearch(zdd &z, dlx::countCache *cache, dlx::columnSet &key, unsigned long &work);
+
+		/**
+		 * Randomized variant of search that stops at the first solution.
+		 * Ties in column selection are broken at random and rows of the selected
+		 * column are tried in random order.
+		 *
+		 * @param k Depth of a search.
+		 * @param g Random number generator
+		 * @param budget Search nodes left; decremented on every node
+		 * @param stop Shared flag of a portfolio (or NULL). Search gives up when
+		 * 		  it becomes nonzero; a solution is reported only by the thread
+		 * 		  that switches it from 0 to 1.
+		 * @param cand Rows to try at every depth; buffers are reused across
+		 * 		  nodes and runs, so the search allocates nothing once they have grown.
+		 * @return 1 if a solution was reported, 0 if the subtree has none,
+		 * 		   -1 if the budget ran out or search was stopped.
+		 */
+		int randomSearch(unsigned int k, dlx::rng &g, unsigned long &budget, volatile int *stop,
+			std::vector<std::vector<link> > &cand);
+
+		/**
+		 * State of optimize(). Costs are negated when maximizing, so that the
+		 * search always minimizes.
+		 */
+		struct bnbState {
+			std::vector<double> cost; /**< Cost of every row */
+			std::vector<double> drop; /**< Sum of the bounds of every row's primary columns */
+			std::vector<std::vector<std::pair<double, link> > > cand; /**< Rows to try at every depth, with their costs */
+			double best; /**< Cost of the incumbent */
+			double sign; /**< -1 when maximizing, 1 otherwise */
+		};
+
+		/**
+		 * Branch-and-bound variant of search.
+		 *
+		 * @param k Depth of a search.
+		 * @param cost Cost of O[0..k-1]
+		 * @param rest Lower bound of the cost of covering the remaining primary columns
+		 * @param b State
+		 */
+		void optimizeSearch(unsigned int k, double cost, double rest, bnbState &b);
+
+		/**
+		 * Fill wide from the rows live now, for the row limit of search.
+		 */
+		void measureRows();
+	public:
+		/**
+		 * Constructor.
+		 */
+		dlxSolver() : CL(1, 0), CR(1, 0), S(1, 0), A(1, 1), active(0), kernel(dlx::minColumnKernel()), prefetchFrom(dlx::prefetchNodes), heads(1), halt(false), incumbent(0),
+			rowsMin(0), rowsMax(0), generation(dlx::nextGeneration()) {
+			h.resize(1); // create master header
+			nodes.resize(1);
+			initHead(0);
+		}
+
+		/**
+		 * Copy constructor.
+		 * Copies the node arena in bulk and then translates its links in one
+		 * sequential pass (offset links need none), which is far cheaper than
+		 * rebuilding with addRow.
+		 * Cannot be used during search.
+		 *
+		 * @param f Foreign object to be copied.
+		 */
+		dlxSolver(const dlxSolver &f);
+
+		/**
+		 * Copy assignment.
+		 *
+		 * @param f Foreign object to be copied.
+		 */
+		dlxSolver &operator=(const dlxSolver &f) {
+			dlxSolver t(f);
+			swap(t);
+			return *this;
+		}
+
+#if __cplusplus >= 201103L
+		/**
+		 * Move constructor.
+		 * Takes over the buffers; no link changes, as vectors keep their addresses.
+		 * The moved-from solver may only be destroyed, assigned to or reset().
+		 *
+		 * @param f Solver to take the matrix from.
+		 */
+		dlxSolver(dlxSolver &&f)
+			: h(std::move(f.h)), CL(std::move(f.CL)), CR(std::move(f.CR)), S(std::move(f.S)), A(std::move(f.A)),
+			  active(f.active), kernel(f.kernel), prefetchFrom(f.prefetchFrom), O(std::move(f.O)), rows(std::move(f.rows)),
+			  state(std::move(f.state)), rowStart(std::move(f.rowStart)), weight(std::move(f.weight)),
+			  nodes(std::move(f.nodes)), heads(f.heads), halt(false), incumbent(0),
+			  rowsMin(f.rowsMin), rowsMax(f.rowsMax), generation(f.generation) {}
+
+		/**
+		 * Move assignment.
+		 * Our previous matrix is released together with f.
+		 *
+		 * @param f Solver to take the matrix from.
+		 */
+		dlxSolver &operator=(dlxSolver &&f) {
+			swap(f);
+			return *this;
+		}
+#endif
+
+		/**
+		 * Destructor.
+		 * Releases the node arena and headers in bulk.
+		 */
+		~dlxSolver() {}
+
+		/**
+		 * Drop the matrix, but keep allocated memory for the next one.
+		 * Afterwards the solver is as if freshly constructed, so setColumnNumber
+		 * and addRow may be called again; nodes go into the same arena.
+		 */
+		void reset();
+
+		/**
+		 * Exchange contents with another solver.
+		 * Constant time; no link needs translation since vectors keep their buffers.
+		 *
+		 * @param f Other solver.
+		 */
+		void swap(dlxSolver &f);
+
+		/**
+		 * Write the matrix to a solver image, which load() maps back.
+		 * Every pointer link is stored as base plus the file offset of its
+		 * target, so an image mapped at base needs no fixups at all, and one
+		 * mapped elsewhere is fixed up by a constant shift. With base 0 the
+		 * links are plain file offsets. Offset links are stored as they are
+		 * and never need fixups.
+		 *
+		 * @attention Must not be called during search.
+		 *
+		 * @param path File name
+		 * @param base Preferred address of the image.
+		 * @return false on I/O error.
+		 */
+		bool save(const char *path, unsigned long base=dlx::imageBase) const;
+
+		/**
+		 * Replace the matrix with a solver image written by save().
+		 * Headers and nodes (column heads included) are not read but mapped privately (copy-on-write)
+		 * at the address the image prefers, so loading takes time in the order
+		 * of columns and rows, not nonzeros, and processes that load one image
+		 * share its pages until search writes to them. If that address is
+		 * taken, links are shifted in place, which touches every page.
+		 * The image must come from a build with the same traits. The header
+		 * and the row table are checked against the file (a truncated or
+		 * inconsistent image is rejected); the links themselves are trusted.
+		 *
+		 * @param path File name
+		 * @return false if the file cannot be read or is not a matching image;
+		 * 		   the matrix is unchanged then.
+		 */
+		bool load(const char *path);
+
+		/**
+		 * Main algorithm
+		 * solution() may set halt to stop after the current solution; the
+		 * matrix is restored on the way out all the same.
+		 *
+		 * @param k Depth of a search.
+		 * @return Returns a reference to results.
+		 */
+		void search(unsigned int k=0);
+
+		/**
+		 * Search under assumptions.
+		 * Forced rows are selected up front (covered exactly as if search had
+		 * chosen them) and appear as O[0], O[1], ... in every solution. Excluded
+		 * rows are unlinked for the duration of the call. The matrix is restored
+		 * exactly afterwards, so queries can be run back to back on one loaded
+		 * matrix.
+		 *
+		 * @param force Row numbers that every solution must contain.
+		 * @param exclude Row numbers that no solution may contain.
+		 * @return false if the forced rows are not compatible with each other
+		 * 		   or with exclude (no search is run then).
+		 */
+		bool search(const std::vector<unsigned int> &force, const std::vector<unsigned int> &exclude=std::vector<unsigned int>());
+
+		/**
+		 * Search under assumptions given as a query, so that copies of one
+		 * solver can serve as workers of batch().
+		 *
+		 * @param q Rows to force and to exclude.
+		 * @return See search(force, exclude).
+		 */
+		bool search(const dlx::query &q) {
+			return search(q.force, q.exclude);
+		}
+
+		/**
+		 * Restrict search (also under assumptions, forced rows included) to
+		 * solutions of least..most rows; limitRows(k, k) asks for exactly k.
+		 * Recursion stops at depth most, and a branch is cut off as soon as
+		 * the rows left cannot cover the uncovered primary columns or are too
+		 * many for them (each covers at least one). For the former, every
+		 * search measures, per column, the widest row still live through it
+		 * (counting primary columns); a row selected later covers at most as
+		 * many as the widest of those over the columns still uncovered.
+		 * Other searches ignore the limits.
+		 *
+		 * @param most Most rows, 0 for no limit.
+		 * @param least Fewest rows.
+		 */
+		void limitRows(unsigned int most, unsigned int least=0) {
+			rowsMin = least;
+			rowsMax = most;
+		}
+
+		/**
+		 * Count solutions without reporting them.
+		 * With a nonzero budget, counts of residual subproblems are memoized in
+		 * a transposition table keyed by the set of covered columns, so that the
+		 * same leftover region reached via different row choices is counted once.
+		 *
+		 * @param budget Memory budget of the transposition table in bytes, 0 disables it.
+		 * @return Number of solutions.
+		 */
+		unsigned long count(std::size_t budget=0);
+
+		/**
+		 * Compile all solutions into a zero-suppressed decision diagram.
+		 * Residual subproblems are memoized by their set of covered columns
+		 * (as in Knuth's DXZ), so the diagram may be exponentially smaller than
+		 * the number of solutions. The result supports counting, uniform
+		 * sampling and streaming enumeration without re-running the search.
+		 *
+		 * @param z Output diagram; its root is set to the compiled family.
+		 * @param budget Memory budget of the subproblem memo in bytes. If it is
+		 * 		  too small, shared subproblems are compiled more than once; the
+		 * 		  diagram is still correct, but bigger and slower to build.
+		 * @return Root vertex.
+		 */
+		unsigned long compile(zdd &z, std::size_t budget);
+
+		/**
+		 * Draw a uniformly random solution and report it via solution(k).
+		 * Walks down the search tree, picking each row with probability
+		 * proportional to the number of solutions below it. Subtree counts come
+		 * from countSearch, so pass the same cache to every call: after the first
+		 * sample most counts are cache hits. The cache is bound to the current
+		 * matrix, so after an edit (addRow, disableRow, ...) it starts over.
+		 *
+		 * @param g Random number generator
+		 * @param cache Subtree-count cache (may be NULL, which is exact but slow)
+		 * @return false if there are no solutions, or if the counts wrapped
+		 * 		   around past ULONG_MAX and no row could be picked; the matrix
+		 * 		   is left as it was either way.
+		 */
+		bool sample(dlx::rng &g, dlx::countCache *cache);
+
+		/**
+		 * Draw an approximately uniform random solution and report it via solution(k).
+		 * Cheap alternative to sample(): a depth-first search that tries rows in
+		 * random order and stops at the first solution. A run that exceeds the
+		 * node budget is abandoned and restarted with fresh random choices.
+		 * Solutions in small subtrees are favoured, so samples are biased.
+		 *
+		 * @param g Random number generator
+		 * @param budget Search nodes per run, 0 means unlimited.
+		 * @param restarts Maximal number of runs.
+		 * @return false if no solution was found.
+		 */
+		bool sampleApprox(dlx::rng &g, unsigned long budget=0, unsigned int restarts=1);
+
+		/**
+		 * Find any solution using randomized restarts and report it via solution(k).
+		 * Deterministic search can get stuck in a huge subtree without solutions;
+		 * running randomized searches with growing node budgets cuts off that
+		 * heavy tail. Runs continue until a solution is found, a run exhausts
+		 * the search space within its budget, or the run limit is reached.
+		 *
+		 * @param g Random number generator
+		 * @param sch Node budgets of consecutive runs
+		 * @param runs Maximal number of runs, 0 means unlimited.
+		 * @param stop Shared flag of a portfolio (see randomSearch), or NULL.
+		 * @return 1 if a solution was found, 0 if there is none (proven by this
+		 * 		   run or, in a portfolio, by another thread), -1 if runs were
+		 * 		   exhausted or search was stopped by a solution elsewhere.
+		 */
+		int searchRestarts(dlx::rng &g, const dlx::schedule &sch=dlx::schedule(), unsigned int runs=0, volatile int *stop=0);
+
+		/**
+		 * Find a solution of least (or greatest) total row weight.
+		 * Branch and bound: every primary column is charged the least cost per
+		 * primary column of the rows through it, and a subtree is cut off when
+		 * the cost of the rows selected so far plus the charges of the columns
+		 * still uncovered cannot beat the best solution found so far. Rows are
+		 * tried cheapest first (relative to the charges they remove), so good
+		 * solutions come early.
+		 *
+		 * Anytime: every solution better than all before is reported via
+		 * solution(k) as soon as it is found, with its cost in incumbent; the
+		 * last one reported is optimal. solution() may set halt to settle for
+		 * the current one.
+		 *
+		 * @param best Receives the cost of the best solution.
+		 * @param maximize Look for the greatest total weight instead.
+		 * @return false if there is no solution.
+		 */
+		bool optimize(double &best, bool maximize=false);
+
+		/**
+		 * Get results.
+		 *
+		 * @return Reference to results.
+		 */
+		const std::vector<link> getResults() { return O; }
+
+		/**
+		 * Set column count.
+		 * Reserves required capacity for output and columns.
+		 *
+		 * @param p Primary columns
+		 * @param s Secondary columns
+		 */
+		void setColumnNumber(index_type p, index_type s=0);
+		
+		/**
+		 * Fills the search matrix.
+		 * This method doesn't check assumptions. Each row shall contain numbers in range
+		 * [1; p+s] (in ascending order) that indicate, in which columns are 1s.
+		 *
+		 * @attention setColumnNumber must be called first.
+		 * 
+		 * @tparam InputIterator Iterator type (as described in SGI's STL documentation).
+		 * @param it Iterator pointing to integers (each x: 0 < x <= p+s) in ascending order.
+		 * @param end Iterator's end point.
+		 * @return Row number, counted from 0.
+		 * @see setColumnNumber
+		 */
+		template <class InputIterator>
+		unsigned int addRow(InputIterator it, InputIterator end);
+
+		/**
+		 * Add a row with a weight (see optimize).
+		 *
+		 * @param it Iterator pointing to column numbers, as for addRow(it, end).
+		 * @param end Iterator's end point.
+		 * @param w Weight of the row
+		 * @return Row number, counted from 0.
+		 */
+		template <class InputIterator>
+		unsigned int addRow(InputIterator it, InputIterator end, double w) {
+			unsigned int r = addRow(it, end);
+			setRowWeight(r, w);
+			return r;
+		}
+
+		/**
+		 * Set the weight of a row. Rows never given one weigh 1.
+		 * Weights are not stored in solver images.
+		 *
+		 * @param r Row number; a row not added yet gets the weight once it is.
+		 * @param w Weight
+		 */
+		void setRowWeight(unsigned int r, double w) {
+			if(weight.size() <= r)
+				weight.resize(std::max<std::size_t>(rows.size(), r+1), 1.0);
+			weight[r] = w;
+		}
+
+		/**
+		 * Weight of a row.
+		 *
+		 * @param r Row number
+		 */
+		double rowWeight(unsigned int r) const { return r < weight.size() ? weight[r] : 1.0; }
+
+		/**
+		 * Add many rows at once, given in compressed sparse row form.
+		 * Row i consists of columns colIndices[rowOffsets[i]..rowOffsets[i+1]),
+		 * under the same contract as addRow. The arena is allocated once; a
+		 * forward pass lays out the rows and links L, R, C and U against a dense
+		 * array of column bottoms, and a backward pass links D. Neither pass
+		 * writes anything but the node at hand (and the dense array), whereas
+		 * addRow also stores into the previous node of each column.
+		 *
+		 * @attention setColumnNumber must be called first.
+		 *
+		 * With several threads, rows are split into ranges of about equal
+		 * nonzero counts. Each thread lays out its range and links it into
+		 * per-thread column sublists; then the sublists of every column are
+		 * stitched together in row order (columns split across the threads
+		 * again) and the sizes summed. The result is the same as with one thread.
+		 * A share whose thread cannot be created is done by the calling thread.
+		 *
+		 * @tparam Offset Integer type of row offsets.
+		 * @tparam Index Integer type of column numbers.
+		 * @param rowOffsets Start of every row in colIndices, plus end of the last one.
+		 * @param colIndices Column numbers, row by row.
+		 * @param threads Number of threads to build with.
+		 * @return Number of the first row added.
+		 */
+		template <class Offset, class Index>
+		unsigned int buildFromCSR(const std::vector<Offset> &rowOffsets, const std::vector<Index> &colIndices, unsigned int threads=1);
+
+		/**
+		 * Preallocate room for rows to be added.
+		 * With exact totals the arena is never moved while the matrix is filled.
+		 *
+		 * @param r Number of rows that will be added.
+		 * @param nonzeros Number of 1s in these rows.
+		 */
+		void reserve(std::size_t r, std::size_t nonzeros);
+
+		/**
+		 * Add a column.
+		 * New primary column is appended to the ring, so it is tried last when
+		 * sizes tie. Column numbers of existing columns do not change.
+		 *
+		 * Costs amortized constant time, before the first row as well as
+		 * after it, so a matrix can be built with addColumn and addRow alone.
+		 * A column head beyond the room reserved for heads doubles the room,
+		 * moving any rows up the arena.
+		 *
+		 * @attention Must not be called during search.
+		 *
+		 * @param primary Whether the column must be covered.
+		 * @return Number of the new column.
+		 */
+		index_type addColumn(bool primary=true);
+
+		/**
+		 * Temporarily remove a row from the matrix.
+		 * Does nothing unless the row is enabled.
+		 *
+		 * @attention Must not be called during search.
+		 *
+		 * @param r Row number (as returned by addRow)
+		 */
+		void disableRow(unsigned int r);
+
+		/**
+		 * Put back a row removed by disableRow.
+		 * Rows may be enabled in any order; the row goes to the bottom of each of
+		 * its columns, so it is tried last in the next search.
+		 * Does nothing unless the row is disabled.
+		 *
+		 * @attention Must not be called during search.
+		 *
+		 * @param r Row number
+		 */
+		void enableRow(unsigned int r);
+
+		/**
+		 * Delete a row for good.
+		 * Its number is not reused; its nodes stay in the arena as dead storage.
+		 *
+		 * @attention Must not be called during search.
+		 *
+		 * @param r Row number
+		 */
+		void removeRow(unsigned int r);
+
+		/**
+		 * Number of rows added so far (including removed ones).
+		 */
+		unsigned int rowCount() const { return rows.size(); }
+
+		/**
+		 * State of a row.
+		 *
+		 * @param r Row number
+		 */
+		rowState getRowState(unsigned int r) const { return static_cast<rowState>(state[r]); }
+
+		/**
+		 * Node a link points to.
+		 *
+		 * @param l Link, e.g. O[i] or the L, R, U or D of a node
+		 */
+		node &at(link l) { return linker::at(&nodes[0], l); }
+
+		/**
+		 * Node a link points to.
+		 *
+		 * @param l Link
+		 */
+		const node &at(link l) const { return linker::at(const_cast<node*>(&nodes[0]), l); }
+
+		/**
+		 * Name of the column a node is in (n.C->N under pointerLinks).
+		 *
+		 * @param n Node
+		 */
+		name_type name(const node &n) const { return h[n.X].N; }
+
+		/**
+		 * Number of the row a node belongs to.
+		 * Binary search over the first nodes of the rows.
+		 *
+		 * @param n Link to the node
+		 */
+		unsigned int rowNumber(link n) const {
+			std::size_t i = linker::index(&nodes[0], n);
+			return std::upper_bound(rowStart.begin(), rowStart.end(), i) - rowStart.begin() - 1;
+		}
+
+		/**
+		 * Row numbers of the current solution, in order of selection.
+		 * Meant to be called from solution(k).
+		 *
+		 * @param k Depth, as passed to solution.
+		 * @param out Receives k row numbers.
+		 */
+		void solutionRows(unsigned int k, std::vector<unsigned int> &out) const {
+			out.resize(k);
+			for(unsigned int i=0; i<k; ++i)
+				out[i] = rowNumber(O[i]);
+		}
+
+		/**
+		 * Interface to user-defined function.
+		 * Uses CRTP to achieve static-polymorphism. Calls user-defined method of the same
+		 * name.
+		 *
+		 * To get results, user should:
+		 *  - for every selected row i = 0, 1, ..., k-1
+		 *  - for every link n = O[i], at(n).R, ... (until n==O[i] again); with
+		 *    pointerLinks that is node *n = O[i], O[i]->R, O[i]->R->R...
+		 *  - get column name with name(at(n)), or n->C->N with pointerLinks
+		 *
+		 * @param k Rows that cover the search-space.
+		 */
+		void solution(unsigned int k) {
+			static_cast<Derived*>(this)->solution(k);
+		}
+
+		/**
+		 * Called by search once row r is selected as O[k] and its columns
+		 * are covered. Does nothing; Derived may define its own (resolved
+		 * statically, like solution) to keep state along the current path,
+		 * e.g. a running cost, so that solution(k) need not look at
+		 * O[0..k-1] again. Every enter is matched by a leave.
+		 *
+		 * @param k Depth
+		 * @param r Selected row
+		 */
+		void enter(unsigned int, link) {}
+
+		/**
+		 * Called by search when row r = O[k] is about to be unselected, before
+		 * its columns are uncovered. Does nothing; see enter.
+		 *
+		 * @param k Depth
+		 * @param r Row being unselected
+		 */
+		void leave(unsigned int, link) {}
+	};
+}
+
+
+template <class Derived, class Traits>
+template <class InputIterator>
+unsigned int kpfp::dlxSolver<Derived, Traits>::addRow(InputIterator it, InputIterator end) {
+	generation = dlx::nextGeneration();
+	std::size_t first = nodes.size();
+	for(; it!=end; ++it) {
+		std::size_t i = newNode();
+		node &n = nodes[i];
+		index_type hN = *it;
+		++S[hN];
+		linker::setHeader(n, &h[hN]);
+		n.X = hN;
+		n.U = nodes[hN].U;
+		n.D = linkAt(hN);
+		at(n.U).D = linkAt(i);
+		nodes[hN].U = linkAt(i);
+	}
+	std::size_t last = nodes.size();
+	for(std::size_t i=first; i<last; ++i) { // link the row, now that the arena won't move
+		nodes[i].L = linkAt(i == first ? last-1 : i-1);
+		nodes[i].R = linkAt(i+1 == last ? first : i+1);
+	}
+	rows.push_back(first == last ? link() : linkAt(first));
+	state.push_back(enabled);
+	rowStart.push_back(first);
+	return rows.size() - 1;
+}
+
+template <class Derived, class Traits>
+template <class Offset, class Index>
+unsigned int kpfp::dlxSolver<Derived, Traits>::buildFromCSR(const std::vector<Offset> &rowOffsets, const std::vector<Index> &colIndices, unsigned int threads) {
+	generation = dlx::nextGeneration();
+	unsigned int first = rows.size();
+	if(rowOffsets.size() < 2)
+		return first;
+	std::size_t nr = rowOffsets.size() - 1;
+	std::size_t base = nodes.size();
+	std::size_t nz = rowOffsets[nr] - rowOffsets[0];
+	if(base + nz > nodes.capacity())
+		growNodes(base + nz);
+	state.insert(state.end(), nr, static_cast<unsigned char>(enabled));
+	rowStart.reserve(rowStart.size() + nr);
+	for(std::size_t r=0; r<nr; ++r)
+		rowStart.push_back(base + (rowOffsets[r] - rowOffsets[0]));
+	if(threads > 1 && nr >= threads && nz) {
+		nodes.extend(base + nz); // every field of every node is written by its thread
+		rows.resize(first + nr);
+		std::vector<buildPart<Offset, Index> > t(threads);
+		std::vector<pthread_t> th(threads);
+		std::size_t r = 0;
+		for(unsigned int i=0; i<threads; ++i) {
+			buildPart<Offset, Index> &p = t[i];
+			p.s = this;
+			p.off = &rowOffsets;
+			p.col = &colIndices;
+			p.r0 = r;
+			if(i + 1 == threads) {
+				r = nr;
+			} else { // first row past our share of nonzeros
+				Offset target = rowOffsets[0] + static_cast<Offset>(nz / threads * (i + 1));
+				r = std::max(r, static_cast<std::size_t>(std::lower_bound(rowOffsets.begin(), rowOffsets.end() - 1, target) - rowOffsets.begin()));
+			}
+			p.r1 = r;
+			p.base = base + (rowOffsets[p.r0] - rowOffsets[0]);
+			p.row0 = first + p.r0;
+			p.c0 = h.size() * i / threads;
+			p.c1 = h.size() * (i + 1) / threads;
+			p.top.assign(h.size(), link());
+			p.bottom.resize(h.size());
+			p.size.assign(h.size(), 0);
+			p.all = &t;
+			p.stitch = false;
+		}
+		std::vector<char> started(threads);
+		for(int phase=0; phase<2; ++phase) {
+			for(unsigned int i=0; i<threads; ++i) {
+				t[i].stitch = phase;
+				started[i] = pthread_create(&th[i], 0, buildRun<Offset, Index>, &t[i]) == 0;
+				if(!started[i]) // shares are independent within a phase, so do it here
+					buildRun<Offset, Index>(&t[i]);
+			}
+			for(unsigned int i=0; i<threads; ++i)
+				if(started[i])
+					pthread_join(th[i], 0);
+		}
+		return first;
+	}
+	rows.reserve(rows.size() + nr);
+	std::vector<link> end(h.size()); // bottom of every column so far
+	for(std::size_t c=0; c<h.size(); ++c)
+		end[c] = nodes[c].U;
+	// pass 1: lay out rows, linking L, R, C, X and U
+	for(std::size_t r=0; r<nr; ++r) {
+		std::size_t f = nodes.size();
+		for(std::size_t i=rowOffsets[r]; i<rowOffsets[r+1]; ++i) {
+			index_type c = colIndices[i];
+			++S[c];
+			std::size_t m = nodes.size();
+			nodes.push_back(node());
+			node &n = nodes[m];
+			linker::setHeader(n, &h[c]);
+			n.X = c;
+			n.U = end[c];
+			n.L = linkAt(m - 1);
+			n.R = linkAt(m + 1);
+			end[c] = linkAt(m);
+		}
+		std::size_t l = nodes.size();
+		if(f != l) {
+			nodes[f].L = linkAt(l-1);
+			nodes[l-1].R = linkAt(f);
+		}
+		rows.push_back(f == l ? link() : linkAt(f));
+	}
+	// pass 2: link D backwards, so that again only the current node is written
+	for(std::size_t c=0; c<h.size(); ++c) {
+		nodes[c].U = end[c];
+		end[c] = linkAt(c); // now: top of the new part of every column
+	}
+	for(std::size_t i=base+nz; i-->base; ) {
+		node &m = nodes[i];
+		index_type c = m.X;
+		m.D = end[c];
+		end[c] = linkAt(i);
+	}
+	for(std::size_t c=0; c<h.size(); ++c) // hang the new part below the old one
+		at(at(end[c]).U).D = end[c];
+	return first;
+}
+
+template <class Derived, class Traits>
+template <class Offset, class Index>
+void *kpfp::dlxSolver<Derived, Traits>::buildRun(void *p) {
+	buildPart<Offset, Index> &t = *static_cast<buildPart<Offset, Index>*>(p);
+	dlxSolver &s = *t.s;
+	if(!t.stitch) { // lay out our rows into our own column sublists
+		std::size_t m = t.base;
+		for(std::size_t r=t.r0; r<t.r1; ++r) {
+			std::size_t f = m;
+			for(std::size_t i=(*t.off)[r]; i<(*t.off)[r+1]; ++i, ++m) {
+				index_type c = (*t.col)[i];
+				++t.size[c];
+				node &n = s.nodes[m];
+				linker::setHeader(n, &s.h[c]);
+				n.X = c;
+				n.L = s.linkAt(m - 1);
+				n.R = s.linkAt(m + 1);
+				if(t.top[c]) {
+					n.U = t.bottom[c];
+					s.at(t.bottom[c]).D = s.linkAt(m);
+				} else {
+					t.top[c] = s.linkAt(m);
+				}
+				t.bottom[c] = s.linkAt(m);
+			}
+			if(f != m) {
+				s.nodes[f].L = s.linkAt(m - 1);
+				s.nodes[m - 1].R = s.linkAt(f);
+			}
+			s.rows[t.row0 + (r - t.r0)] = f == m ? link() : s.linkAt(f);
+		}
+	} else { // append every thread's sublist of our columns, in row order
+		for(std::size_t c=t.c0; c<t.c1; ++c) {
+			link b = s.nodes[c].U;
+			for(std::size_t i=0; i<t.all->size(); ++i) {
+				buildPart<Offset, Index> &q = (*t.all)[i];
+				if(!q.top[c])
+					continue;
+				s.at(b).D = q.top[c];
+				s.at(q.top[c]).U = b;
+				b = q.bottom[c];
+				s.S[c] += q.size[c];
+			}
+			s.at(b).D = s.linkAt(c);
+			s.nodes[c].U = b;
+		}
+	}
+	return 0;
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::growNodes(std::size_t n) {
+	if(n - 1 > linker::last)
+		throw std::length_error("dlxSolver: node arena exceeds the range of links");
+	dlx::arena<node> nn;
+	nn.reserve(n);
+	nn.assign(nodes.begin(), nodes.end());
+	const node *old = &nodes[0];
+	nodes.swap(nn);
+	if(!linker::stable)
+		relocate(old);
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::growHeads(std::size_t n) {
+	if(n <= heads)
+		return;
+	std::size_t size = nodes.size();
+	std::size_t m = std::max(n, 2*heads);
+	std::size_t room = linker::last - size + 1; // arena slots links can still reach
+	if(m - heads > room / 2) // leave the other half to rows
+		m = std::max(n, heads + room / 2);
+	std::size_t shift = m - heads;
+	if(size + shift > nodes.capacity()) // double, as far as links reach
+		growNodes(std::max(size + shift, nodes.capacity() <= linker::last / 2 ? 2*nodes.capacity() : linker::last));
+	nodes.extend(size + shift);
+	std::memmove(&nodes[m], &nodes[heads], (size - heads) * sizeof(node));
+	std::memset(static_cast<void*>(&nodes[heads]), 0, shift * sizeof(node));
+	std::size_t from = heads;
+	heads = m;
+	for(std::size_t i=0; i<rowStart.size(); ++i)
+		rowStart[i] += shift;
+	relocate(&nodes[0], from, shift);
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::reserve(std::size_t r, std::size_t nonzeros) {
+	rows.reserve(rows.size() + r);
+	state.reserve(state.size() + r);
+	rowStart.reserve(rowStart.size() + r);
+	if(nodes.size() + nonzeros > nodes.capacity())
+		growNodes(nodes.size() + nonzeros);
+}
+
+template <class Derived, class Traits>
+std::size_t kpfp::dlxSolver<Derived, Traits>::newNode() {
+	if(nodes.size() == nodes.capacity()) { // double, as far as links reach
+		std::size_t n = nodes.size() + 1;
+		if(nodes.size() <= linker::last / 2)
+			n = 2*nodes.size();
+		else if(n < linker::last)
+			n = linker::last;
+		growNodes(n);
+	}
+	nodes.push_back(node());
+	return nodes.size() - 1;
+}
+
+template <class Derived, class Traits>
+kpfp::dlxSolver<Derived, Traits>::dlxSolver(const dlxSolver &f)
+	: h(f.h), CL(f.CL), CR(f.CR), S(f.S), A(f.A), active(f.active), kernel(f.kernel), prefetchFrom(f.prefetchFrom),
+	  O(f.O), rows(f.rows), state(f.state), rowStart(f.rowStart), weight(f.weight), nodes(f.nodes), heads(f.heads),
+	  halt(false), incumbent(0), rowsMin(f.rowsMin), rowsMax(f.rowsMax), generation(f.generation) {
+	if(!linker::stable)
+		relocate(&f.nodes[0]);
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::reset() {
+	h.resize(1);
+	nodes.resize(1);
+	heads = 1;
+	initHead(0);
+	CL.assign(1, 0);
+	CR.assign(1, 0);
+	S.assign(1, 0);
+	A.assign(1, 1);
+	active = 0;
+	kernel = dlx::minColumnKernel();
+	prefetchFrom = dlx::prefetchNodes;
+	O.clear();
+	rows.clear();
+	state.clear();
+	rowStart.clear();
+	weight.clear();
+	halt = false;
+	rowsMin = rowsMax = 0;
+	wide.clear();
+	trail.clear();
+	marks.clear();
+	generation = dlx::nextGeneration();
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::swap(dlxSolver &f) {
+	h.swap(f.h);
+	CL.swap(f.CL);
+	CR.swap(f.CR);
+	S.swap(f.S);
+	A.swap(f.A);
+	std::swap(active, f.active);
+	std::swap(kernel, f.kernel);
+	std::swap(prefetchFrom, f.prefetchFrom);
+	O.swap(f.O);
+	rows.swap(f.rows);
+	state.swap(f.state);
+	rowStart.swap(f.rowStart);
+	weight.swap(f.weight);
+	nodes.swap(f.nodes);
+	std::swap(heads, f.heads);
+	std::swap(halt, f.halt);
+	std::swap(incumbent, f.incumbent);
+	std::swap(rowsMin, f.rowsMin);
+	std::swap(rowsMax, f.rowsMax);
+	wide.swap(f.wide);
+	trail.swap(f.trail);
+	marks.swap(f.marks);
+	std::swap(generation, f.generation);
+}
+
+template <class Derived, class Traits>
+bool kpfp::dlxSolver<Derived, Traits>::save(const char *path, unsigned long base) const {
+	dlx::imageHeader ih;
+	std::memset(&ih, 0, sizeof(ih));
+	std::memcpy(ih.magic, "DLXIMG3", 8);
+	ih.layout[0] = sizeof(node);
+	ih.layout[1] = sizeof(header);
+	ih.layout[2] = sizeof(index_type);
+	ih.layout[3] = sizeof(size_type);
+	ih.layout[4] = sizeof(name_type);
+	ih.layout[5] = Traits::links::width;
+	ih.base = base;
+	ih.columns = h.size();
+	ih.heads = heads;
+	ih.nodes = nodes.size();
+	ih.rows = rows.size();
+	ih.active = active;
+	dlx::imageLayout(ih);
+
+	FILE *f = std::fopen(path, "wb");
+	if(!f)
+		return false;
+	unsigned long pos = 0;
+	bool ok = dlx::imageWrite(f, pos, 0, &ih, sizeof(ih));
+	ok = ok && dlx::imageWrite(f, pos, ih.off[0], &h[0], h.size() * sizeof(header));
+	// where the arena and the headers will be once mapped at base
+	node *wantN = reinterpret_cast<node*>(static_cast<std::size_t>(base + ih.off[1]));
+	header *wantH = reinterpret_cast<header*>(static_cast<std::size_t>(base + ih.off[0]));
+	for(std::size_t i=0; i<nodes.size() && ok; ++i) {
+		node x = nodes[i];
+		if(!linker::stable && (i < h.size() || i >= heads)) { // slots between are unused
+			x.L = linker::make(wantN, linker::index(&nodes[0], x.L));
+			x.R = linker::make(wantN, linker::index(&nodes[0], x.R));
+			x.U = linker::make(wantN, linker::index(&nodes[0], x.U));
+			x.D = linker::make(wantN, linker::index(&nodes[0], x.D));
+			linker::setHeader(x, wantH + x.X);
+		}
+		ok = dlx::imageWrite(f, pos, ih.off[1], &x, sizeof(x));
+	}
+	ok = ok && dlx::imageWrite(f, pos, ih.off[2], &CL[0], CL.size() * sizeof(index_type))
+		&& dlx::imageWrite(f, pos, ih.off[3], &CR[0], CR.size() * sizeof(index_type))
+		&& dlx::imageWrite(f, pos, ih.off[4], &S[0], S.size() * sizeof(size_type))
+		&& dlx::imageWrite(f, pos, ih.off[5], &A[0], A.size() * sizeof(size_type));
+	for(std::size_t i=0; i<rowStart.size() && ok; ++i) {
+		unsigned long x = rowStart[i];
+		ok = dlx::imageWrite(f, pos, ih.off[6], &x, sizeof(x));
+	}
+	ok = ok && dlx::imageWrite(f, pos, ih.off[7], state.empty() ? 0 : &state[0], state.size());
+	return std::fclose(f) == 0 && ok;
+}
+
+template <class Derived, class Traits>
+bool kpfp::dlxSolver<Derived, Traits>::load(const char *path) {
+	int fd = open(path, O_RDONLY);
+	if(fd < 0)
+		return false;
+	dlx::imageHeader ih;
+	std::memset(&ih, 0, sizeof(ih));
+	struct stat st;
+	bool ok = dlx::imageRead(fd, 0, &ih, sizeof(ih)) && std::memcmp(ih.magic, "DLXIMG3", 8) == 0
+		&& ih.layout[0] == sizeof(node) && ih.layout[1] == sizeof(header) && ih.layout[2] == sizeof(index_type)
+		&& ih.layout[3] == sizeof(size_type) && ih.layout[4] == sizeof(name_type)
+		&& ih.layout[5] == Traits::links::width && fstat(fd, &st) == 0;
+	if(ok) { // every section must be where save() puts it and inside the file
+		unsigned long len = st.st_size;
+		dlx::imageHeader want = ih;
+		// counts above the file length would overflow the layout; every element takes a byte at least
+		ok = ih.columns > 0 && ih.columns <= ih.heads && ih.heads <= ih.nodes && ih.nodes <= len
+			&& ih.rows <= len && ih.active < ih.columns;
+		if(ok)
+			dlx::imageLayout(want);
+		ok = ok && std::memcmp(want.off, ih.off, sizeof(ih.off)) == 0 && want.size == ih.size && ih.size <= len;
+	}
+	dlxSolver t;
+	header *wantH = reinterpret_cast<header*>(static_cast<std::size_t>(ih.base + ih.off[0]));
+	node *wantN = reinterpret_cast<node*>(static_cast<std::size_t>(ih.base + ih.off[1]));
+	ok = ok && t.h.map(fd, ih.off[0], ih.columns, wantH) && t.nodes.map(fd, ih.off[1], ih.nodes, wantN);
+	if(ok) {
+		t.CL.resize(ih.columns);
+		t.CR.resize(ih.columns);
+		t.S.resize(ih.columns);
+		t.A.resize(ih.columns);
+		std::vector<unsigned long> r(ih.rows);
+		t.state.resize(ih.rows);
+		ok = dlx::imageRead(fd, ih.off[2], &t.CL[0], ih.columns * sizeof(index_type))
+			&& dlx::imageRead(fd, ih.off[3], &t.CR[0], ih.columns * sizeof(index_type))
+			&& dlx::imageRead(fd, ih.off[4], &t.S[0], ih.columns * sizeof(size_type))
+			&& dlx::imageRead(fd, ih.off[5], &t.A[0], ih.columns * sizeof(size_type))
+			&& (r.empty() || (dlx::imageRead(fd, ih.off[6], &r[0], ih.rows * sizeof(unsigned long))
+				&& dlx::imageRead(fd, ih.off[7], &t.state[0], ih.rows)));
+		for(std::size_t i=0; i<r.size() && ok; ++i) // rows must lie inside the arena past the heads, in order
+			ok = r[i] >= ih.heads && r[i] <= ih.nodes && (i == 0 || r[i-1] <= r[i]);
+		t.rowStart.assign(r.begin(), r.end());
+		t.rows.resize(ih.rows);
+	}
+	close(fd);
+	if(!ok)
+		return false;
+	t.heads = ih.heads;
+	t.active = static_cast<index_type>(ih.active);
+	t.O.assign(ih.columns - 1, link());
+	if(!linker::stable && (&t.h[0] != wantH || &t.nodes[0] != wantN))
+		t.relocate(wantN);
+	for(std::size_t i=0; i<t.rows.size(); ++i) { // no node for removed and empty rows
+		std::size_t end = i+1 < t.rows.size() ? t.rowStart[i+1] : t.nodes.size();
+		t.rows[i] = t.state[i] == removed || t.rowStart[i] == end ? link() : t.linkAt(t.rowStart[i]);
+	}
+	swap(t);
+	return true;
+}
+
+template <class Derived, class Traits>
+typename kpfp::dlxSolver<Derived, Traits>::index_type kpfp::dlxSolver<Derived, Traits>::addColumn(bool primary) {
+	generation = dlx::nextGeneration();
+	index_type x = static_cast<index_type>(h.size());
+	growHeads(h.size() + 1);
+	if(h.size() == h.capacity()) {
+		dlx::arena<header> nh;
+		nh.reserve(2*h.size());
+		nh.assign(h.begin(), h.end());
+		h.swap(nh);
+		if(!linker::stable) // header pointers only
+			relocate(&nodes[0]);
+	}
+	h.push_back(header());
+	h[x].N = static_cast<name_type>(x);
+	initHead(x);
+	S.push_back(0);
+	A.push_back(primary ? 0 : 1);
+	O.push_back(link());
+	if(primary) { // insert before master, i.e. at the end of the ring
+		CL.push_back(CL[0]);
+		CR.push_back(0);
+		CR[CL[0]] = x;
+		CL[0] = x;
+		++active;
+	} else {
+		CL.push_back(x);
+		CR.push_back(x);
+	}
+	return x;
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::relocate(const node *old, std::size_t from, std::size_t shift) {
+	node *to = &nodes[0];
+#define DLX_RELOCATE(l) { \
+		std::size_t k = linker::index(old, l); \
+		l = linker::make(to, k < from ? k : k + shift); \
+	}
+	for(std::size_t i=0; i<nodes.size(); i = i+1 == h.size() ? heads : i+1) { // unused head slots are skipped
+		node &n = nodes[i];
+		DLX_RELOCATE(n.L)
+		DLX_RELOCATE(n.R)
+		DLX_RELOCATE(n.U)
+		DLX_RELOCATE(n.D)
+		linker::setHeader(n, &h[n.X]);
+	}
+	for(std::size_t i=0; i<rows.size(); ++i) {
+		if(rows[i])
+			DLX_RELOCATE(rows[i])
+	}
+	for(std::size_t i=0; i<O.size(); ++i) {
+		if(O[i])
+			DLX_RELOCATE(O[i])
+	}
+#undef DLX_RELOCATE
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::unlinkRow(link n) {
+	link j = n;
+	do {
+		node &x = at(j);
+		at(x.D).U = x.U;
+		at(x.U).D = x.D;
+		--S[x.X];
+		j = x.R;
+	} while(j != n);
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::relinkRow(link n) {
+	link j = n;
+	do {
+		j = at(j).L;
+		node &x = at(j);
+		++S[x.X];
+		at(x.D).U = j;
+		at(x.U).D = j;
+	} while(j != n);
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::disableRow(unsigned int r) {
+	if(state[r] != enabled)
+		return;
+	generation = dlx::nextGeneration();
+	state[r] = disabled;
+	if(rows[r])
+		unlinkRow(rows[r]);
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::enableRow(unsigned int r) {
+	if(state[r] != disabled)
+		return;
+	generation = dlx::nextGeneration();
+	state[r] = enabled;
+	link n = rows[r];
+	if(!n)
+		return;
+	do {
+		node &x = at(n);
+		node &c = nodes[x.X];
+		x.U = c.U;
+		x.D = linkAt(x.X);
+		at(c.U).D = n;
+		c.U = n;
+		++S[x.X];
+		n = x.R;
+	} while(n != rows[r]);
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::removeRow(unsigned int r) {
+	if(state[r] == removed)
+		return;
+	disableRow(r);
+	state[r] = removed;
+	rows[r] = link();
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::setColumnNumber(index_type p, index_type s) {
+	generation = dlx::nextGeneration();
+	std::size_t sum = static_cast<std::size_t>(p)+s;
+	growHeads(sum+1);
+	O.resize(sum);
+	h.resize(sum+1);
+	CL.resize(sum+1);
+	CR.resize(sum+1);
+	S.assign(sum+1, 0);
+	A.assign(sum+1, 1);
+	active = p;
+
+	for(std::size_t i=0; i<=sum; ++i) {
+		h[i].N = static_cast<name_type>(i);
+		initHead(i);
+		if(i && i<=p)
+			A[i] = 0;
+		// primary columns form a ring with master header, secondary ones are alone
+		CL[i] = static_cast<index_type>(i<=p ? (i+p)%(p+1) : i);
+		CR[i] = static_cast<index_type>(i<=p ? (i+1)%(p+1) : i);
+	}
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::search(unsigned int k) {
+	if(k == 0) {
+		halt = false;
+		if(rowsMax)
+			measureRows();
+	}
+	if(CR[0] == 0) { // termination condition
+		if(k >= rowsMin && (!rowsMax || k <= rowsMax))
+			solution(k);
+		return;
+	}
+	if(rowsMax) {
+		if(k >= rowsMax)
+			return;
+		unsigned int w = 0;
+		for(index_type j=CR[0]; j!=0; j=CR[j])
+			w = std::max(w, wide[j]);
+		if(static_cast<std::size_t>(rowsMax - k) * w < active)
+			return; // not enough rows left to cover what is uncovered
+	}
+	if(rowsMin > k && rowsMin - k > active)
+		return; // too many rows left, each needs a column of its own
+	index_type c = chooseColumn();
+	cover(c); // cover column c
+	for(link r=nodes[c].D; r!=linkAt(c) && !halt; r=at(r).D) { // for each row...
+		O[k] = r;
+		for(link j=at(r).R; j!=r; j=at(j).R) // for each column of this node...
+			cover(at(j).X);
+		static_cast<Derived*>(this)->enter(k, r);
+		search(k+1);
+		r = O[k];
+		c = at(r).X;
+		static_cast<Derived*>(this)->leave(k, r);
+		for(link j=at(r).L; j!=r; j=at(j).L)
+			uncover(at(j).X);
+	}
+	uncover(c); //uncover column c
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::measureRows() {
+	// rows still linked into an uncovered column are live, and so are all their primary columns
+	wide.assign(h.size(), 0);
+	for(index_type c=CR[0]; c!=0; c=CR[c]) {
+		for(link r=nodes[c].D; r!=linkAt(c); r=at(r).D) {
+			unsigned int w = 1;
+			for(link j=at(r).R; j!=r; j=at(j).R)
+				w += A[at(j).X] == 0;
+			wide[c] = std::max(wide[c], w);
+		}
+	}
+}
+
+template <class Derived, class Traits>
+bool kpfp::dlxSolver<Derived, Traits>::search(const std::vector<unsigned int> &force, const std::vector<unsigned int> &exclude) {
+	halt = false;
+	std::vector<unsigned int> off; // rows unlinked here, in order
+	for(std::size_t i=0; i<exclude.size(); ++i) {
+		unsigned int r = exclude[i];
+		if(state[r] == enabled) {
+			state[r] = disabled;
+			if(rows[r])
+				unlinkRow(rows[r]);
+			off.push_back(r);
+		}
+	}
+	std::vector<char> used(h.size(), 0); // columns covered by forced rows
+	unsigned int k = 0;
+	bool ok = true;
+	for(std::size_t i=0; i<force.size() && ok; ++i) {
+		link r = rows[force[i]];
+		if(std::find(O.begin(), O.begin() + k, r) != O.begin() + k)
+			continue; // forced twice
+		ok = r && state[force[i]] == enabled;
+		for(link j=r; ok; j=at(j).R) {
+			ok = !used[at(j).X];
+			used[at(j).X] = 1;
+			if(at(j).R == r)
+				break;
+		}
+		if(!ok)
+			break;
+		O[k] = r;
+		cover(at(r).X);
+		for(link j=at(r).R; j!=r; j=at(j).R)
+			cover(at(j).X);
+		static_cast<Derived*>(this)->enter(k++, r);
+	}
+	if(ok && k && rowsMax)
+		measureRows(); // search(0) does it itself
+	if(ok)
+		search(k);
+	while(k--) {
+		static_cast<Derived*>(this)->leave(k, O[k]);
+		for(link j=at(O[k]).L; j!=O[k]; j=at(j).L)
+			uncover(at(j).X);
+		uncover(at(O[k]).X);
+	}
+	while(!off.empty()) {
+		unsigned int r = off.back();
+		off.pop_back();
+		state[r] = enabled;
+		if(rows[r])
+			relinkRow(rows[r]);
+	}
+	return ok;
+}
+
+template <class Derived, class Traits>
+typename kpfp::dlxSolver<Derived, Traits>::index_type kpfp::dlxSolver<Derived, Traits>::chooseColumn() {
+	// select column (to minimize branching factor)
+	if(active >= 64 && active >= A.size()/8)
+		return static_cast<index_type>(dlx::minColumn(kernel, &S[0], &A[0], A.size()));
+	index_type c = CR[0];
+	size_type s = S[c];
+	for(index_type j=CR[c]; j!=0; j=CR[j]) {
+		if(S[j] < s) {
+			s = S[j];
+			c = j;
+		}
+	}
+	return c;
+}
+
+template <class Derived, class Traits>
+typename kpfp::dlxSolver<Derived, Traits>::index_type kpfp::dlxSolver<Derived, Traits>::chooseColumn(dlx::rng &g) {
+	index_type c = CR[0];
+	size_type s = S[c];
+	unsigned long ties = 1;
+	for(index_type j=CR[c]; j!=0; j=CR[j]) {
+		if(S[j] < s) {
+			s = S[j];
+			c = j;
+			ties = 1;
+		} else if(S[j] == s && g.below(++ties) == 0) { // reservoir sampling
+			c = j;
+		}
+	}
+	return c;
+}
+
+template <class Derived, class Traits>
+unsigned long kpfp::dlxSolver<Derived, Traits>::count(std::size_t budget) {
+	dlx::columnSet key(h.size());
+	dlx::countCache cache(budget);
+	unsigned long work = 0;
+	return countSearch(budget ? &cache : 0, key, work);
+}
+
+template <class Derived, class Traits>
+unsigned long kpfp::dlxSolver<Derived, Traits>::countSearch(dlx::countCache *cache, dlx::columnSet &key, unsigned long &work) {
+	++work;
+	if(CR[0] == 0) // termination condition
+		return 1;
+	unsigned long total = 0;
+	if(cache && cache->find(key, total))
+		return total;
+	unsigned long before = work;
+	index_type c = chooseColumn();
+	cover(c);
+	key.flip(c);
+	for(link r=nodes[c].D; r!=linkAt(c); r=at(r).D) {
+		for(link j=at(r).R; j!=r; j=at(j).R) {
+			cover(at(j).X);
+			key.flip(at(j).X);
+		}
+		total += countSearch(cache, key, work);
+		for(link j=at(r).L; j!=r; j=at(j).L) {
+			key.flip(at(j).X);
+			uncover(at(j).X);
+		}
+	}
+	key.flip(c);
+	uncover(c);
+	if(cache)
+		cache->insert(key, total, work - before + 1);
+	return total;
+}
+
+template <class Derived, class Traits>
+unsigned long kpfp::dlxSolver<Derived, Traits>::compile(zdd &z, std::size_t budget) {
+	dlx::columnSet key(h.size());
+	dlx::countCache cache(budget);
+	unsigned long work = 0;
+	z.root = zddSearch(z, budget ? &cache : 0, key, work);
+	return z.root;
+}
+
+template <class Derived, class Traits>
+unsigned long kpfp::dlxSolver<Derived, Traits>::zddSearch(zdd &z, dlx::countCache *cache, dlx::columnSet &key, unsigned long &work) {
+	++work;
+	if(CR[0] == 0) // termination condition
+		return zdd::top;
+	unsigned long f = zdd::bottom;
+	if(cache && cache->find(key, f))
+		return f;
+	unsigned long before = work;
+	index_type c = chooseColumn();
+	cover(c);
+	key.flip(c);
+	// build the LO chain bottom-up, so the first row ends up on top
+	for(link r=nodes[c].U; r!=linkAt(c); r=at(r).U) {
+		for(link j=at(r).R; j!=r; j=at(j).R) {
+			cover(at(j).X);
+			key.flip(at(j).X);
+		}
+		unsigned long sub = zddSearch(z, cache, key, work);
+		for(link j=at(r).L; j!=r; j=at(j).L) {
+			key.flip(at(j).X);
+			uncover(at(j).X);
+		}
+		f = z.make(rowNumber(r), f, sub);
+	}
+	key.flip(c);
+	uncover(c);
+	if(cache)
+		cache->insert(key, f, work - before + 1);
+	return f;
+}
+
+template <class Derived, class Traits>
+bool kpfp::dlxSolver<Derived, Traits>::sample(dlx::rng &g, dlx::countCache *cache) {
+	if(cache)
+		cache->bind(generation);
+	dlx::columnSet key(h.size());
+	unsigned long work = 0;
+	unsigned long total = countSearch(cache, key, work);
+	if(!total)
+		return false;
+	unsigned int k = 0;
+	bool ok = true;
+	while(CR[0] != 0) {
+		index_type c = chooseColumn();
+		cover(c);
+		key.flip(c);
+		unsigned long x = g.below(total);
+		link r = nodes[c].D;
+		for(; r!=linkAt(c); r=at(r).D) {
+			for(link j=at(r).R; j!=r; j=at(j).R) {
+				cover(at(j).X);
+				key.flip(at(j).X);
+			}
+			unsigned long n = countSearch(cache, key, work);
+			if(x < n) { // descend into this row
+				O[k] = r;
+				static_cast<Derived*>(this)->enter(k++, r);
+				total = n;
+				break;
+			}
+			x -= n;
+			for(link j=at(r).L; j!=r; j=at(j).L) {
+				key.flip(at(j).X);
+				uncover(at(j).X);
+			}
+		}
+		if(r == linkAt(c)) { // counts disagree with the matrix (wrapped around), no row picked
+			uncover(c);
+			ok = false;
+			break;
+		}
+	}
+	if(ok)
+		solution(k);
+	while(k--) {
+		static_cast<Derived*>(this)->leave(k, O[k]);
+		for(link j=at(O[k]).L; j!=O[k]; j=at(j).L)
+			uncover(at(j).X);
+		uncover(at(O[k]).X);
+	}
+	return ok;
+}
+
+template <class Derived, class Traits>
+bool kpfp::dlxSolver<Derived, Traits>::sampleApprox(dlx::rng &g, unsigned long budget, unsigned int restarts) {
+	std::vector<std::vector<link> > cand(O.size() + 1);
+	while(restarts--) {
+		unsigned long b = budget ? budget : ULONG_MAX;
+		int res = randomSearch(0, g, b, 0, cand);
+		if(res >= 0)
+			return res > 0;
+	}
+	return false;
+}
+
+template <class Derived, class Traits>
+int kpfp::dlxSolver<Derived, Traits>::searchRestarts(dlx::rng &g, const dlx::schedule &sch, unsigned int runs, volatile int *stop) {
+	std::vector<std::vector<link> > cand(O.size() + 1);
+	for(unsigned int i=0; !runs || i<runs; ++i) {
+		unsigned long b = sch(i);
+		int res = randomSearch(0, g, b, stop, cand);
+		if(res == 0 && stop && !__sync_bool_compare_and_swap(stop, 0, 2))
+			return *stop == 2 ? 0 : -1;
+		if(res >= 0)
+			return res;
+		if(stop && *stop)
+			return *stop == 2 ? 0 : -1;
+	}
+	return -1;
+}
+
+template <class Derived, class Traits>
+int kpfp::dlxSolver<Derived, Traits>::randomSearch(unsigned int k, dlx::rng &g, unsigned long &budget, volatile int *stop,
+		std::vector<std::vector<link> > &cand) {
+	if(CR[0] == 0) { // termination condition
+		if(stop && !__sync_bool_compare_and_swap(stop, 0, 1))
+			return -1;
+		solution(k);
+		return 1;
+	}
+	if(!budget || (stop && *stop))
+		return -1;
+	--budget;
+	index_type c = chooseColumn(g);
+	std::vector<link> &rs = cand[k];
+	rs.clear();
+	for(link r=nodes[c].D; r!=linkAt(c); r=at(r).D)
+		rs.push_back(r);
+	int res = 0;
+	cover(c);
+	for(std::size_t i=rs.size(); i>0 && res==0; --i) {
+		std::swap(rs[i-1], rs[g.below(i)]); // Fisher-Yates, one step at a time
+		link r = rs[i-1];
+		O[k] = r;
+		for(link j=at(r).R; j!=r; j=at(j).R)
+			cover(at(j).X);
+		static_cast<Derived*>(this)->enter(k, r);
+		res = randomSearch(k+1, g, budget, stop, cand);
+		static_cast<Derived*>(this)->leave(k, r);
+		for(link j=at(r).L; j!=r; j=at(j).L)
+			uncover(at(j).X);
+	}
+	uncover(c);
+	return res;
+}
+
+template <class Derived, class Traits>
+bool kpfp::dlxSolver<Derived, Traits>::optimize(double &best, bool maximize) {
+	halt = false;
+	const double inf = std::numeric_limits<double>::infinity();
+	bnbState b;
+	b.sign = maximize ? -1.0 : 1.0;
+	b.best = inf;
+	b.cost.assign(rows.size(), 0.0);
+	b.drop.assign(rows.size(), 0.0);
+	b.cand.resize(O.size() + 1);
+	// charge of a column: least cost per primary column of its rows
+	std::vector<double> bound(h.size(), inf);
+	std::vector<unsigned int> width(rows.size(), 0);
+	for(unsigned int r=0; r<rows.size(); ++r) {
+		if(!rows[r] || state[r] != enabled)
+			continue;
+		b.cost[r] = b.sign * rowWeight(r);
+		link n = rows[r];
+		do {
+			width[r] += A[at(n).X] == 0;
+			n = at(n).R;
+		} while(n != rows[r]);
+		if(!width[r])
+			continue; // never selected
+		double share = b.cost[r] / width[r];
+		n = rows[r];
+		do {
+			index_type c = at(n).X;
+			if(A[c] == 0)
+				bound[c] = std::min(bound[c], share);
+			n = at(n).R;
+		} while(n != rows[r]);
+	}
+	double rest = 0;
+	for(index_type c=CR[0]; c!=0; c=CR[c])
+		rest += bound[c];
+	if(rest == inf)
+		return false; // some column has no rows
+	for(unsigned int r=0; r<rows.size(); ++r) {
+		if(!width[r])
+			continue;
+		link n = rows[r];
+		do {
+			if(A[at(n).X] == 0)
+				b.drop[r] += bound[at(n).X];
+			n = at(n).R;
+		} while(n != rows[r]);
+	}
+	optimizeSearch(0, 0.0, rest, b);
+	if(b.best == inf)
+		return false;
+	best = b.sign * b.best;
+	return true;
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::optimizeSearch(unsigned int k, double cost, double rest, bnbState &b) {
+	if(CR[0] == 0) { // termination condition
+		if(cost < b.best) {
+			b.best = cost;
+			incumbent = b.sign * cost;
+			solution(k);
+		}
+		return;
+	}
+	if(cost + rest >= b.best)
+		return;
+	index_type c = chooseColumn();
+	std::vector<std::pair<double, link> > &cand = b.cand[k];
+	cand.clear();
+	for(link r=nodes[c].D; r!=linkAt(c); r=at(r).D) {
+		unsigned int i = rowNumber(r);
+		cand.push_back(std::make_pair(b.cost[i] - b.drop[i], r)); // excess over the charges it removes
+	}
+	std::sort(cand.begin(), cand.end());
+	cover(c);
+	for(std::size_t i=0; i<cand.size() && !halt; ++i) {
+		// cand[i].first grows, so once the bound fails it fails for the rest
+		if(cost + rest + cand[i].first >= b.best)
+			break;
+		link r = cand[i].second;
+		unsigned int n = rowNumber(r);
+		O[k] = r;
+		for(link j=at(r).R; j!=r; j=at(j).R)
+			cover(at(j).X);
+		static_cast<Derived*>(this)->enter(k, r);
+		optimizeSearch(k+1, cost + b.cost[n], rest - b.drop[n], b);
+		static_cast<Derived*>(this)->leave(k, r);
+		for(link j=at(r).L; j!=r; j=at(j).L)
+			uncover(at(j).X);
+	}
+	uncover(c);
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::cover(index_type x) {
+	const link c = linkAt(x);
+	CR[CL[x]] = CR[x];
+	CL[CR[x]] = CL[x];
+	active -= (A[x]++ == 0);
+	const bool ahead = nodes.size() >= prefetchFrom;
+	if(Traits::trail)
+		marks.push_back(trail.size());
+	for(link i=at(c).D; i!=c; i=at(i).D) {
+		link n = at(i).D; // fetched by the previous round
+		if(ahead && n != c) { // request the next row's neighbours and the row after it
+			DLX_PREFETCH(&at(at(n).D));
+			for(link j=at(n).R; j!=n; j=at(j).R) {
+				DLX_PREFETCH(&at(at(j).U));
+				DLX_PREFETCH(&at(at(j).D));
+			}
+		}
+		for(link j=at(i).R; j!=i; j=at(j).R) {
+			node &m = at(j);
+			at(m.D).U = m.U;
+			at(m.U).D = m.D;
+			--S[m.X];
+			if(Traits::trail)
+				trail.push_back(j);
+		}
+	}
+}
+
+template <class Derived, class Traits>
+void kpfp::dlxSolver<Derived, Traits>::uncover(index_type x) {
+	if(Traits::trail) {
+		// a removed node keeps its own U and D, and they are its neighbours
+		// again once everything removed after it is back
+		std::size_t m = marks.back();
+		marks.pop_back();
+		while(trail.size() > m) {
+			link j = trail.back();
+			trail.pop_back();
+			node &m = at(j);
+			++S[m.X];
+			at(m.D).U = j;
+			at(m.U).D = j;
+		}
+		CR[CL[x]] = x;
+		CL[CR[x]] = x;
+		active += (--A[x] == 0);
+		return;
+	}
+	const link c = linkAt(x);
+	const bool ahead = nodes.size() >= prefetchFrom;
+	for(link i=at(c).U; i!=c; i=at(i).U) {
+		link n = at(i).U; // as in cover, one row ahead
+		if(ahead && n != c) {
+			DLX_PREFETCH(&at(at(n).U));
+			for(link j=at(n).L; j!=n; j=at(j).L) {
+				DLX_PREFETCH(&at(at(j).U));
+				DLX_PREFETCH(&at(at(j).D));
+			}
+		}
+		for(link j=at(i).L; j!=i; j=at(j).L) {
+			node &m = at(j);
+			++S[m.X];
+			at(m.D).U = j;
+			at(m.U).D = j;
+		}
+	}
+	CR[CL[x]] = x;
+	CL[CR[x]] = x;
+	active += (--A[x] == 0);
+}
+
+namespace kpfp {
+	namespace dlx {
+		enum { unsat = -2 }; /**< Result of portfolio when the matrix has no solution */
 
 		/**
-		 * Node structure.
-		 * Take a note, that for performance reasons, no constructor is given, thus
-		 * all members take default values.
+		 * Work item of a portfolio thread.
 		 */
-		struct node {
-			node *L; /**< Node to the left */
-			node *R; /**< Node to the right */
-			node *U; /**< Node above */
-			node *D; /**< Node below */
-			header *C; /**< Link to the current column's header */
+		template <class Solver>
+		struct portfolioTask {
+			Solver *s; /**< Solver owned by this thread */
+			const schedule *sch; /**< Restart schedule */
+			unsigned long seed; /**< Seed of this thread's generator */
+			unsigned int runs; /**< Run limit */
+			volatile int *stop; /**< Shared stop flag */
+			int res; /**< Result of searchRestarts */
 		};
-	
+
 		/**
-		 * Header structure.
-		 * Take a note, that for performance reasons, no constructor is given, thus
-		 * all members take default values.
+		 * Thread entry point of a portfolio.
+		 *
+		 * @param p Pointer to portfolioTask<Solver>
+		 */
+		template <class Solver>
+		void *portfolioRun(void *p) {
+			portfolioTask<Solver> *t = static_cast<portfolioTask<Solver>*>(p);
+			rng g(t->seed);
+			t->res = t->s->searchRestarts(g, *t->sch, t->runs, t->stop);
+			return 0;
+		}
+	}
+
+	/**
+	 * Find any solution with a portfolio of randomized restarting searches.
+	 * Each solver runs searchRestarts in its own thread with a different seed;
+	 * the first one to find a solution reports it via its solution(k) (called
+	 * from that thread) and stops the others.
+	 *
+	 * @attention Solvers must be distinct objects holding the same matrix, as
+	 * 			  search modifies the links.
+	 *
+	 * @tparam Solver Class derived from dlxSolver.
+	 * @param s Array of n solvers.
+	 * @param n Number of solvers (threads).
+	 * @param sch Node budgets of consecutive runs.
+	 * @param seed Base seed.
+	 * @param runs Run limit per thread, 0 means unlimited.
+	 * @return Index of the solver that found a solution, dlx::unsat (-2) if some thread
+	 * 		   proved that there is none, -1 if the run limits were reached first.
+	 * 		   If a thread cannot be created, its solver runs in the calling
+	 * 		   thread and the solvers after it are left out.
+	 */
+	template <class Solver>
+	int portfolio(Solver **s, unsigned int n, const dlx::schedule &sch=dlx::schedule(), unsigned long seed=1, unsigned int runs=0) {
+		volatile int stop = 0;
+		std::vector<dlx::portfolioTask<Solver> > t(n);
+		std::vector<pthread_t> th(n);
+		unsigned int started = 0;
+		for(unsigned int i=0; i<n; ++i) {
+			t[i].s = s[i];
+			t[i].sch = &sch;
+			t[i].seed = seed + i;
+			t[i].runs = runs;
+			t[i].stop = &stop;
+			t[i].res = -1;
+		}
+		for(; started<n; ++started) {
+			if(pthread_create(&th[started], 0, dlx::portfolioRun<Solver>, &t[started]) != 0) {
+				dlx::portfolioRun<Solver>(&t[started]);
+				break;
+			}
+		}
+		int winner = -1;
+		for(unsigned int i=0; i<n; ++i) {
+			if(i < started)
+				pthread_join(th[i], 0);
+			if(t[i].res == 1)
+				winner = i;
+			else if(t[i].res == 0 && winner < 0)
+				winner = dlx::unsat;
+		}
+		return winner;
+	}
+}
+
+namespace kpfp {
+	namespace dlx {
+		/**
+		 * Immutable exact cover matrix, stored both by rows and by columns.
+		 * Built once and then shared read-only by any number of sharedSolver
+		 * workers, each of which keeps its own mutable overlay.
 		 */
-		struct header : public node {
-			int S; /**< Size, i.e. number of 1's in this column */
-			int N; /**< Name of current header */
+		class matrix {
+		public:
+			unsigned int primary; /**< Primary columns are 1..primary */
+			unsigned int columns; /**< Columns are 1..columns */
+			std::vector<unsigned int> rowStart; /**< Row r has columns rowCols[rowStart[r]..rowStart[r+1]) */
+			std::vector<unsigned int> rowCols; /**< Column numbers, row by row */
+			std::vector<unsigned int> colStart; /**< Column c has rows colRows[colStart[c]..colStart[c+1]) */
+			std::vector<unsigned int> colRows; /**< Row numbers, column by column */
+
+			/**
+			 * Constructor.
+			 */
+			matrix() : primary(0), columns(0), rowStart(1, 0) {}
+
+			/**
+			 * Set column count.
+			 *
+			 * @param p Primary columns
+			 * @param s Secondary columns
+			 */
+			void setColumnNumber(unsigned int p, unsigned int s=0) {
+				primary = p;
+				columns = p + s;
+			}
+
+			/**
+			 * Add a row.
+			 * Same contract as dlxSolver::addRow. Call finish() after the last row.
+			 *
+			 * @tparam InputIterator Iterator type (as described in SGI's STL documentation).
+			 * @param it Iterator pointing to integers (each x: 0 < x <= p+s) in ascending order.
+			 * @param end Iterator's end point.
+			 * @return Row number, counted from 0.
+			 */
+			template <class InputIterator>
+			unsigned int addRow(InputIterator it, InputIterator end) {
+				for(; it!=end; ++it)
+					rowCols.push_back(*it);
+				rowStart.push_back(rowCols.size());
+				return rowStart.size() - 2;
+			}
+
+			/**
+			 * Preallocate room for rows to be added.
+			 *
+			 * @param r Number of rows that will be added.
+			 * @param nonzeros Number of 1s in these rows.
+			 */
+			void reserve(std::size_t r, std::size_t nonzeros) {
+				rowStart.reserve(rowStart.size() + r);
+				rowCols.reserve(rowCols.size() + nonzeros);
+			}
+
+			/**
+			 * Number of rows.
+			 */
+			unsigned int rows() const { return rowStart.size() - 1; }
+
+			/**
+			 * Build the column-wise index (counting sort of the rows).
+			 */
+			void finish() {
+				colStart.assign(columns + 2, 0);
+				for(std::size_t i=0; i<rowCols.size(); ++i)
+					++colStart[rowCols[i] + 1];
+				for(unsigned int c=1; c<colStart.size(); ++c)
+					colStart[c] += colStart[c-1];
+				colRows.resize(rowCols.size());
+				std::vector<unsigned int> fill(colStart.begin(), colStart.end() - 1);
+				for(unsigned int r=0; r<rows(); ++r) {
+					for(unsigned int i=rowStart[r]; i<rowStart[r+1]; ++i)
+						colRows[fill[rowCols[i]]++] = r;
+				}
+			}
 		};
 	}
 
 	/**
-	 * Solves generalized exact cover problem using DLX algorithm.
-	 * Single-threaded.
+	 * Solves exact cover problem on a shared, read-only dlx::matrix.
+	 * Rows are never unlinked: covering column c marks every live row of c
+	 * dead, stamped with the depth of that cover, and takes it off the
+	 * counts of its other columns; uncovering c revives exactly the rows
+	 * stamped by it. Scans over a column's rows walk the immutable colRows
+	 * and skip dead ones, which is what the small overlay costs: deep in the
+	 * search most rows a cover walks are dead already. Rows of a column are
+	 * always tried in row order.
+	 * Active primary columns form a sparse set, restored by moving its
+	 * boundary back.
+	 * Memory: each solver keeps a stamp per row and a count per column,
+	 * O(rows + columns) and independent of the number of nonzeros, so many
+	 * workers can answer queries on one big matrix at once.
+	 * Single-threaded; use one object per thread.
 	 *
 	 * @tparam Derived Static polymorphism via CRTP. Used to return results
 	 * 		   to user-defined functions.
 	 */
 	template <class Derived>
-	class dlxSolver {
+	class sharedSolver {
 	protected:
-		std::vector<dlx::header> h; /**< Headers. h[0] is master header. */
-		std::vector<dlx::node*> O; /**< Result vector. */
+		const dlx::matrix *M; /**< Shared matrix */
+		std::vector<unsigned int> S; /**< Live rows in each uncovered column */
+		std::vector<unsigned int> dead; /**< Depth of the cover that removed each row, 0 if live, excluded for excluded rows */
+		std::vector<unsigned int> item; /**< Sparse set: item[0..active) are the active primary columns */
+		std::vector<unsigned int> pos; /**< Position of each primary column in item */
+		unsigned int active; /**< Number of active primary columns */
+		unsigned int depth; /**< Covers in effect */
+		std::vector<unsigned int> ex; /**< Excluded rows of the current query */
+		std::vector<unsigned int> O; /**< Result vector (row numbers). */
+
+		enum { excluded = UINT_MAX }; /**< Stamp of rows excluded by a query */
+
+		/**
+		 * Mark row r dead and take it off the counts of its columns.
+		 *
+		 * @param r Row, live.
+		 * @param stamp Depth to record.
+		 * @param skip Column whose count stays (the one being covered), or 0.
+		 */
+		void kill(unsigned int r, unsigned int stamp, unsigned int skip) {
+			// locals, as stores into S could alias the matrix for the compiler
+			const unsigned int *i = &M->rowCols[0] + M->rowStart[r], *end = &M->rowCols[0] + M->rowStart[r+1];
+			unsigned int *s = &S[0];
+			dead[r] = stamp;
+			for(; i!=end; ++i)
+				if(*i != skip)
+					--s[*i];
+		}
+
+		/**
+		 * Undo kill(r, stamp, skip).
+		 *
+		 * @param r Row
+		 * @param skip Same as for kill.
+		 */
+		void revive(unsigned int r, unsigned int skip) {
+			const unsigned int *i = &M->rowCols[0] + M->rowStart[r], *end = &M->rowCols[0] + M->rowStart[r+1];
+			unsigned int *s = &S[0];
+			dead[r] = 0;
+			for(; i!=end; ++i)
+				if(*i != skip)
+					++s[*i];
+		}
 
 		/**
 		 * Cover column c.
 		 *
-		 * @param c Header
+		 * @param c Column
 		 */
-		void cover(dlx::header *c);
+		void cover(unsigned int c);
 
 		/**
 		 * Uncover column c.
 		 *
-		 * @param c Header
+		 * @param c Column
 		 */
-		void uncover(dlx::header*);
-	public:
+		void uncover(unsigned int c);
+
 		/**
-		 * Constructor.
+		 * Select row r: cover all its columns.
+		 *
+		 * @param r Row
 		 */
-		dlxSolver() {
-			h.resize(1); // create master header
+		void select(unsigned int r) {
+			for(unsigned int i=M->rowStart[r]; i<M->rowStart[r+1]; ++i)
+				cover(M->rowCols[i]);
 		}
 
 		/**
-		 * Copy constructor.
+		 * Undo select(r).
 		 *
-		 * @param f Foreign object to be copied.
+		 * @param r Row
 		 */
-		dlxSolver(const dlxSolver &f);
+		void unselect(unsigned int r) {
+			for(unsigned int i=M->rowStart[r+1]; i>M->rowStart[r]; --i)
+				uncover(M->rowCols[i-1]);
+		}
+	public:
+		/**
+		 * Constructor.
+		 *
+		 * @param m Matrix, finish() must have been called. Not copied; it must
+		 * 		  outlive the solver.
+		 */
+		explicit sharedSolver(const dlx::matrix &m);
 
 		/**
 		 * Main algorithm
 		 *
 		 * @param k Depth of a search.
-		 * @return Returns a reference to results.
 		 */
 		void search(unsigned int k=0);
 
 		/**
-		 * Get results.
+		 * Search under assumptions (see dlxSolver::search(force, exclude)).
+		 * Every query leaves the overlay exactly as it found it.
 		 *
-		 * @return Reference to results.
+		 * @param q Rows to force and to exclude.
+		 * @return false if the forced rows are not compatible.
 		 */
-		const std::vector<dlx::node*> getResults() { return O; }
+		bool search(const dlx::query &q);
 
 		/**
-		 * Set column count.
-		 * Reserves required capacity for output and columns.
-		 *
-		 * @param p Primary columns
-		 * @param s Secondary columns
-		 */
-		void setColumnNumber(unsigned int p, unsigned int s=0);
-		
-		/**
-		 * Fills the search matrix.
-		 * This method doesn't check assumptions. Each row shall contain numbers in range
-		 * [1; p+s] (in ascending order) that indicate, in which columns are 1s.
+		 * Get results.
 		 *
-		 * @attention setColumnNumber must be called first.
-		 * 
-		 * @tparam InputIterator Iterator type (as described in SGI's STL documentation).
-		 * @param it Iterator pointing to integers (each x: 0 < x <= p+s) in ascending order.
-		 * @param end Iterator's end point.
-		 * @see setColumnNumber
+		 * @return Row numbers of the current solution (first k are valid).
 		 */
-		template <class InputIterator>
-		void addRow(InputIterator it, InputIterator end);
+		const std::vector<unsigned int> &getResults() const { return O; }
 
 		/**
 		 * Interface to user-defined function.
 		 * Uses CRTP to achieve static-polymorphism. Calls user-defined method of the same
-		 * name.
-		 *
-		 * To get results, user should:
-		 *  - for every selected row i = 0, 1, ..., k-1
-		 *  - for every kpfp::dlx::node *n = O[i], O[i]->R, O[i]->R->R... (until n==O[i] again).
-		 *  - get column number with n->C->N
+		 * name. Selected rows are O[0], ..., O[k-1].
 		 *
 		 * @param k Rows that cover the search-space.
 		 */
 		void solution(unsigned int k) {
 			static_cast<Derived*>(this)->solution(k);
 		}
+
+		/**
+		 * Called by search once row r is selected as O[k]. Does nothing;
+		 * Derived may define its own (see dlxSolver::enter).
+		 *
+		 * @param k Depth
+		 * @param r Selected row
+		 */
+		void enter(unsigned int, unsigned int) {}
+
+		/**
+		 * Called by search when row r = O[k] is about to be unselected.
+		 * Does nothing; see enter.
+		 *
+		 * @param k Depth
+		 * @param r Row being unselected
+		 */
+		void leave(unsigned int, unsigned int) {}
 	};
-}
 
+	namespace dlx {
+		/**
+		 * State shared by batch threads.
+		 */
+		template <class Worker>
+		struct batchTask {
+			Worker *w; /**< Worker owned by this thread */
+			const std::vector<query> *q; /**< Queries */
+			volatile unsigned long *next; /**< Next query to take */
+		};
 
-template <class Derived>
-template <class InputIterator>
-void kpfp::dlxSolver<Derived>::addRow(InputIterator it, InputIterator end) {
-	dlx::node s; /* sentry */
-	s.R = &s;
-	dlx::node *l = &s; /* node to the left */
+		/**
+		 * Thread entry point of a batch.
+		 * Worker's member `current` is set to the query number before each query.
+		 *
+		 * @param p Pointer to batchTask<Worker>
+		 */
+		template <class Worker>
+		void *batchRun(void *p) {
+			batchTask<Worker> *t = static_cast<batchTask<Worker>*>(p);
+			for(;;) {
+				unsigned long i = __sync_fetch_and_add(t->next, 1UL);
+				if(i >= t->q->size())
+					return 0;
+				t->w->current = i;
+				t->w->search((*t->q)[i]);
+			}
+		}
+	}
 
-	for(; it!=end; ++it) {
-		dlx::node *n = new dlx::node();
-		int hN = *it;
-		++h[hN].S;
-		n->C = &h[hN];
-		n->U = h[hN].U;
-		n->D = &h[hN];
-		n->L = l;
-		l->R = n;
-		h[hN].U->D = n;
-		h[hN].U = n;
-		l = n;
-	}
-	l->R = s.R;
-	s.R->L = l;
+	/**
+	 * Answer a batch of queries on one shared matrix with several threads.
+	 * Threads take queries in order from a shared counter. Each worker's
+	 * solution(k) is called from its thread; its `current` member (which
+	 * Worker must declare) holds the number of the query being answered.
+	 * If a thread cannot be created, its worker takes queries in the calling
+	 * thread and no further threads are started; every query is answered.
+	 *
+	 * @tparam Worker Class derived from sharedSolver, or from dlxSolver (one
+	 * 		   copy of the loaded solver per thread).
+	 * @param w Array of n workers on the same matrix.
+	 * @param n Number of workers (threads).
+	 * @param q Queries.
+	 */
+	template <class Worker>
+	void batch(Worker **w, unsigned int n, const std::vector<dlx::query> &q) {
+		volatile unsigned long next = 0;
+		std::vector<dlx::batchTask<Worker> > t(n);
+		std::vector<pthread_t> th(n);
+		unsigned int started = 0;
+		for(; started<n; ++started) {
+			t[started].w = w[started];
+			t[started].q = &q;
+			t[started].next = &next;
+			if(pthread_create(&th[started], 0, dlx::batchRun<Worker>, &t[started]) != 0) {
+				dlx::batchRun<Worker>(&t[started]);
+				break;
+			}
+		}
+		for(unsigned int i=0; i<started; ++i)
+			pthread_join(th[i], 0);
+	}
 }
 
 template <class Derived>
-void kpfp::dlxSolver<Derived>::setColumnNumber(unsigned int p, unsigned int s) {
-	O.resize(p+s);
-	h.resize(p+s+1);
-
-	h[0].R = &h[0];
-	
-	unsigned int i = 1;
-	for(; i<=p; ++i) {
-		h[i].L = &h[i-1];
-		h[i].L->R = &h[i];
-		h[i].U = h[i].D = &h[i];
-		h[i].N = i;
+kpfp::sharedSolver<Derived>::sharedSolver(const dlx::matrix &m) : M(&m), active(0), depth(0) {
+	S.resize(M->columns + 1);
+	for(unsigned int c=1; c<=M->columns; ++c)
+		S[c] = M->colStart[c+1] - M->colStart[c];
+	dead.assign(M->rows(), 0);
+	item.resize(M->primary);
+	pos.resize(M->primary + 1);
+	active = M->primary;
+	for(unsigned int c=1; c<=M->primary; ++c) {
+		item[c-1] = c;
+		pos[c] = c-1;
 	}
-	h[p].R = &h[0];
-	h[0].L = &h[p];
+	O.resize(M->columns);
+}
 
-	unsigned int sum = p+s;
-	for(; i<=sum; ++i) {
-		h[i].L = h[i].R = h[i].U = h[i].D = &h[i];
-		h[i].N = i;
+template <class Derived>
+bool kpfp::sharedSolver<Derived>::search(const dlx::query &q) {
+	// every search leaves S, dead and the active set as it found them
+	ex.clear();
+	for(std::size_t i=0; i<q.exclude.size(); ++i) {
+		unsigned int r = q.exclude[i];
+		if(M->rowStart[r] != M->rowStart[r+1] && !dead[r]) {
+			kill(r, excluded, 0);
+			ex.push_back(r);
+		}
+	}
+	unsigned int k = 0;
+	bool ok = true;
+	for(std::size_t i=0; i<q.force.size() && ok; ++i) {
+		unsigned int r = q.force[i];
+		if(std::find(O.begin(), O.begin() + k, r) != O.begin() + k)
+			continue; // forced twice
+		ok = M->rowStart[r] != M->rowStart[r+1] && !dead[r];
+		if(ok) {
+			O[k] = r;
+			select(r);
+			static_cast<Derived*>(this)->enter(k++, r);
+		}
 	}
+	if(ok)
+		search(k);
+	while(k--) {
+		static_cast<Derived*>(this)->leave(k, O[k]);
+		unselect(O[k]);
+	}
+	while(!ex.empty()) {
+		revive(ex.back(), 0);
+		ex.pop_back();
+	}
+	return ok;
 }
 
 template <class Derived>
-void kpfp::dlxSolver<Derived>::search(unsigned int k) {
-	dlx::header &m = h[0];
-	if(m.R == &m && m.L == &m) { // termination condition
+void kpfp::sharedSolver<Derived>::search(unsigned int k) {
+	if(active == 0) { // termination condition
 		solution(k);
 		return;
 	}
 	// select column (to minimize branching factor)
-	dlx::header *c = static_cast<dlx::header*>(m.R);
-	int s = c->S;
-	for(dlx::node *j=m.R; j!=static_cast<dlx::node*>(&m); j=j->R) {
-		if(static_cast<dlx::header*>(j)->S < s) {
-			s = static_cast<dlx::header*>(j)->S;
-			c = static_cast<dlx::header*>(j);
-		}
+	unsigned int c = item[0];
+	for(unsigned int i=1; i<active; ++i) {
+		if(S[item[i]] < S[c])
+			c = item[i];
 	}
-	cover(c); // cover column c
-	for(dlx::node *r=c->D; r!=c; r=r->D) { // for each row...
+	cover(c);
+	// c's live rows now carry the stamp of this cover, and covering the
+	// other columns of one of them leaves the rest alone
+	const unsigned int t = depth;
+	for(unsigned int i=M->colStart[c]; i<M->colStart[c+1]; ++i) { // for each live row...
+		unsigned int r = M->colRows[i];
+		if(dead[r] != t)
+			continue;
 		O[k] = r;
-		for(dlx::node *j=r->R; j!=r; j=j->R) // for each column of this node...
-			cover(j->C);
+		for(unsigned int j=M->rowStart[r]; j<M->rowStart[r+1]; ++j)
+			if(M->rowCols[j] != c)
+				cover(M->rowCols[j]);
+		static_cast<Derived*>(this)->enter(k, r);
 		search(k+1);
-		r = O[k];
-		c = r->C;
-		for(dlx::node *j=r->L; j!=r; j=j->L)
-			uncover(j->C);
+		static_cast<Derived*>(this)->leave(k, r);
+		for(unsigned int j=M->rowStart[r+1]; j>M->rowStart[r]; --j)
+			if(M->rowCols[j-1] != c)
+				uncover(M->rowCols[j-1]);
 	}
-	uncover(c); //uncover column c
+	uncover(c);
 }
 
 template <class Derived>
-void kpfp::dlxSolver<Derived>::cover(dlx::header *c) {
-	c->R->L = c->L;
-	c->L->R = c->R;
-	for(dlx::node *i=c->D; i!=static_cast<dlx::node*>(c); i=i->D) {
-		for(dlx::node *j=i->R; j!=i; j=j->R) {
-			j->D->U = j->U;
-			j->U->D = j->D;
-			--(j->C->S);
-		}
+void kpfp::sharedSolver<Derived>::cover(unsigned int c) {
+	const unsigned int t = ++depth;
+	const unsigned int *i = &M->colRows[0] + M->colStart[c], *end = &M->colRows[0] + M->colStart[c+1];
+	for(; i!=end; ++i) // rows stay counted in c itself
+		if(!dead[*i])
+			kill(*i, t, c);
+	if(c <= M->primary) { // swap c to the end of the active set
+		unsigned int p = pos[c];
+		unsigned int last = item[--active];
+		item[p] = last;
+		pos[last] = p;
+		item[active] = c;
+		pos[c] = active;
 	}
 }
 
 template <class Derived>
-void kpfp::dlxSolver<Derived>::uncover(dlx::header *c) {
-	for(dlx::node *i=c->U; i!=static_cast<dlx::node*>(c); i=i->U) {
-		for(dlx::node *j=i->L; j!=i; j=j->L) {
-			++(j->C->S);
-			j->D->U = j;
-			j->U->D = j;
+void kpfp::sharedSolver<Derived>::uncover(unsigned int c) {
+	if(c <= M->primary)
+		++active; // c is still at item[active]
+	const unsigned int t = depth--;
+	const unsigned int *i = &M->colRows[0] + M->colStart[c], *end = &M->colRows[0] + M->colStart[c+1];
+	for(; i!=end; ++i)
+		if(dead[*i] == t)
+			revive(*i, c);
+}
+
+namespace kpfp {
+	namespace dlx {
+		/**
+		 * Index of the lowest set bit.
+		 *
+		 * @param x Word, nonzero
+		 */
+		inline unsigned int lowestBit(unsigned long x) {
+#ifdef __GNUC__
+			return __builtin_ctzl(x);
+#else
+			unsigned int n = 0;
+			for(; !(x & 1UL); x >>= 1)
+				++n;
+			return n;
+#endif
+		}
+	}
+
+	/**
+	 * Solves exact cover problem whose dimensions are known at compile time.
+	 * Rows and columns are stored as fixed-size bitsets, so there is no
+	 * dynamic allocation and no pointer chasing: selecting a row is a few
+	 * word-wise OR/ANDNOT loops with compile-time trip counts, which the
+	 * compiler unrolls, plus a size update for every row it knocks out. Each
+	 * level of recursion keeps its own copy of the state (active rows, active
+	 * columns, column sizes), so nothing has to be undone on backtrack. Meant
+	 * for small, fixed-shape puzzles such as 9x9 Sudoku (324 columns, 729 rows).
+	 *
+	 * @tparam Derived Static polymorphism via CRTP. Used to return results
+	 * 		   to user-defined functions.
+	 * @tparam P Number of primary columns.
+	 * @tparam Sec Number of secondary columns.
+	 * @tparam R Maximal number of rows.
+	 */
+	template <class Derived, unsigned int P, unsigned int Sec, unsigned int R>
+	class fixedSolver {
+	public:
+		enum {
+			B = sizeof(unsigned long) * CHAR_BIT, /**< Bits per word */
+			N = P + Sec, /**< Number of columns */
+			CW = (N + B) / B, /**< Words per column set (bit 0 unused) */
+			RW = (R + B - 1) / B /**< Words per row set */
+		};
+	protected:
+		unsigned long colRows[N+1][RW]; /**< Rows having a 1 in each column */
+		unsigned int size[N+1]; /**< Rows having a 1 in each column, counted */
+		unsigned long rowCols[R][CW]; /**< Columns of each row */
+		unsigned long primary[CW]; /**< Primary columns */
+		unsigned int rows; /**< Number of rows added */
+		unsigned int O[N]; /**< Result vector (row numbers). */
+
+		/**
+		 * Search state of one level.
+		 */
+		struct state {
+			unsigned long ra[RW]; /**< Rows still in the matrix */
+			unsigned long ca[CW]; /**< Primary columns still to be covered */
+			unsigned int S[N+1]; /**< Live rows in each column */
+		};
+
+		/**
+		 * Main algorithm on explicit state.
+		 *
+		 * @param k Depth of a search.
+		 * @param st Current state.
+		 */
+		void search(unsigned int k, const state &st);
+
+		/**
+		 * Select row r: remove its columns and all rows that conflict with it.
+		 *
+		 * @param r Row
+		 * @param st State, updated.
+		 */
+		void select(unsigned int r, state &st) const {
+			unsigned long kill[RW];
+			std::fill(kill, kill + RW, 0UL);
+			for(unsigned int w=0; w<CW; ++w) {
+				for(unsigned long x=rowCols[r][w]; x; x&=x-1) {
+					const unsigned long *cr = colRows[w*B + dlx::lowestBit(x)];
+					for(unsigned int i=0; i<RW; ++i)
+						kill[i] |= cr[i];
+				}
+				st.ca[w] &= ~rowCols[r][w];
+			}
+			for(unsigned int i=0; i<RW; ++i) {
+				kill[i] &= st.ra[i];
+				st.ra[i] &= ~kill[i];
+				for(unsigned long x=kill[i]; x; x&=x-1) {
+					const unsigned long *rc = rowCols[i*B + dlx::lowestBit(x)];
+					for(unsigned int w=0; w<CW; ++w) {
+						for(unsigned long y=rc[w]; y; y&=y-1)
+							--st.S[w*B + dlx::lowestBit(y)];
+					}
+				}
+			}
+		}
+	public:
+		/**
+		 * Constructor.
+		 */
+		fixedSolver() {
+			reset();
+		}
+
+		/**
+		 * Drop all rows.
+		 */
+		void reset() {
+			rows = 0;
+			std::fill(&colRows[0][0], &colRows[0][0] + (N+1)*RW, 0UL);
+			std::fill(size, size + N+1, 0U);
+			std::fill(primary, primary + CW, 0UL);
+			for(unsigned int c=1; c<=P; ++c)
+				primary[c / B] |= 1UL << (c % B);
+		}
+
+		/**
+		 * Set column count.
+		 * Dimensions are fixed by template parameters; this exists so that code
+		 * written for dlxSolver can fill a fixedSolver, too.
+		 */
+		void setColumnNumber(unsigned int, unsigned int=0) {}
+
+		/**
+		 * Preallocate room for rows; storage is fixed, so this does nothing.
+		 */
+		void reserve(std::size_t, std::size_t) {}
+
+		/**
+		 * Fills the search matrix.
+		 * Same contract as dlxSolver::addRow; at most R rows may be added.
+		 *
+		 * @tparam InputIterator Iterator type (as described in SGI's STL documentation).
+		 * @param it Iterator pointing to integers (each x: 0 < x <= P+Sec).
+		 * @param end Iterator's end point.
+		 * @return Row number, counted from 0.
+		 */
+		template <class InputIterator>
+		unsigned int addRow(InputIterator it, InputIterator end) {
+			unsigned int r = rows++;
+			std::fill(rowCols[r], rowCols[r] + CW, 0UL);
+			for(; it!=end; ++it) {
+				unsigned int c = *it;
+				if(rowCols[r][c / B] >> (c % B) & 1UL)
+					continue; // repeated column
+				rowCols[r][c / B] |= 1UL << (c % B);
+				colRows[c][r / B] |= 1UL << (r % B);
+				++size[c];
+			}
+			return r;
+		}
+
+		/**
+		 * Main algorithm
+		 */
+		void search() {
+			std::vector<unsigned int> none;
+			search(none);
+		}
+
+		/**
+		 * Search with forced rows (see dlxSolver::search(force, exclude)).
+		 *
+		 * @param force Row numbers that every solution must contain.
+		 * @return false if the forced rows are not compatible, or one of them
+		 * 		   is empty or out of range.
+		 */
+		bool search(const std::vector<unsigned int> &force);
+
+		/**
+		 * Get results.
+		 *
+		 * @return Row numbers of the current solution (first k are valid).
+		 */
+		const unsigned int *getResults() const { return O; }
+
+		/**
+		 * Interface to user-defined function.
+		 * Uses CRTP to achieve static-polymorphism. Calls user-defined method of the same
+		 * name. Selected rows are O[0], ..., O[k-1].
+		 *
+		 * @param k Rows that cover the search-space.
+		 */
+		void solution(unsigned int k) {
+			static_cast<Derived*>(this)->solution(k);
 		}
+
+		/**
+		 * Called by search once row r is selected as O[k]. Does nothing;
+		 * Derived may define its own (see dlxSolver::enter).
+		 *
+		 * @param k Depth
+		 * @param r Selected row
+		 */
+		void enter(unsigned int, unsigned int) {}
+
+		/**
+		 * Called by search when row r = O[k] is about to be unselected.
+		 * Does nothing; see enter.
+		 *
+		 * @param k Depth
+		 * @param r Row being unselected
+		 */
+		void leave(unsigned int, unsigned int) {}
+	};
+}
+
+template <class Derived, unsigned int P, unsigned int Sec, unsigned int R>
+bool kpfp::fixedSolver<Derived, P, Sec, R>::search(const std::vector<unsigned int> &force) {
+	state st;
+	std::fill(st.ra, st.ra + RW, 0UL);
+	for(unsigned int r=0; r<rows; ++r)
+		st.ra[r / B] |= 1UL << (r % B);
+	std::copy(primary, primary + CW, st.ca);
+	std::copy(size, size + N+1, st.S);
+	unsigned int k = 0;
+	bool ok = true;
+	for(std::size_t i=0; i<force.size() && ok; ++i) {
+		unsigned int r = force[i];
+		if(std::find(O, O + k, r) != O + k)
+			continue; // forced twice
+		ok = r < rows && st.ra[r / B] >> (r % B) & 1UL
+			&& std::count(rowCols[r], rowCols[r] + CW, 0UL) < CW; // empty rows cover nothing
+		if(!ok)
+			break;
+		O[k] = r;
+		select(r, st);
+		static_cast<Derived*>(this)->enter(k++, r);
 	}
-	c->L->R = c;
-	c->R->L = c;
+	if(ok)
+		search(k, st);
+	while(k--)
+		static_cast<Derived*>(this)->leave(k, O[k]);
+	return ok;
 }
 
+template <class Derived, unsigned int P, unsigned int Sec, unsigned int R>
+void kpfp::fixedSolver<Derived, P, Sec, R>::search(unsigned int k, const state &st) {
+	// select column (to minimize branching factor)
+	unsigned int c = 0;
+	unsigned int s = R + 1;
+	for(unsigned int w=0; w<CW && s>1; ++w) {
+		for(unsigned long x=st.ca[w]; x; x&=x-1) {
+			unsigned int j = w*B + dlx::lowestBit(x);
+			if(st.S[j] < s) {
+				s = st.S[j];
+				c = j;
+				if(s <= 1)
+					break;
+			}
+		}
+	}
+	if(c == 0) { // termination condition
+		solution(k);
+		return;
+	}
+	state next;
+	for(unsigned int w=0; w<RW; ++w) { // for each row...
+		for(unsigned long x=colRows[c][w] & st.ra[w]; x; x&=x-1) {
+			unsigned int r = w*B + dlx::lowestBit(x);
+			next = st;
+			select(r, next);
+			O[k] = r;
+			static_cast<Derived*>(this)->enter(k, r);
+			search(k+1, next);
+			static_cast<Derived*>(this)->leave(k, r);
+		}
+	}
+}
@@ -0,0 +1,251 @@
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace kpfp {
+	/**
+	 * Generators of classic exact cover problems.
+	 * Each one fills a solver (dlxSolver, fixedSolver or dlx::matrix) directly
+	 * through setColumnNumber, reserve and addRow, so no text representation
+	 * of the matrix is ever built. Totals are computed first and passed to
+	 * reserve, hence addRow never grows anything: setColumnNumber makes room
+	 * for the column heads, and reserve then moves the node arena once, to
+	 * its final size.
+	 */
+	namespace gen {
+		/**
+		 * Unit cell of a polyomino or polycube.
+		 */
+		struct cell {
+			int x, y, z;
+
+			cell(int x_=0, int y_=0, int z_=0) : x(x_), y(y_), z(z_) {}
+			bool operator<(const cell &o) const {
+				return x != o.x ? x < o.x : y != o.y ? y < o.y : z < o.z;
+			}
+			bool operator==(const cell &o) const {
+				return x == o.x && y == o.y && z == o.z;
+			}
+		};
+
+		typedef std::vector<cell> shape; /**< Piece: a set of cells */
+
+		/**
+		 * Translate a shape to the origin and sort its cells, so that equal
+		 * shapes compare equal.
+		 *
+		 * @param p Shape, normalized in place.
+		 */
+		inline void normalize(shape &p) {
+			int mx = p[0].x, my = p[0].y, mz = p[0].z;
+			for(std::size_t i=1; i<p.size(); ++i) {
+				mx = std::min(mx, p[i].x);
+				my = std::min(my, p[i].y);
+				mz = std::min(mz, p[i].z);
+			}
+			for(std::size_t i=0; i<p.size(); ++i) {
+				p[i].x -= mx;
+				p[i].y -= my;
+				p[i].z -= mz;
+			}
+			std::sort(p.begin(), p.end());
+		}
+
+		/**
+		 * All distinct orientations of a piece.
+		 * The closure of the piece under quarter turns about the three axes
+		 * (24 rotations) and, optionally, a mirror image. A flat piece turned
+		 * over about an axis in its plane gives its planar reflection, so for
+		 * polyominoes the rotations alone already yield the usual 8 orientations
+		 * (the ones standing upright do not fit a flat board). Symmetric pieces
+		 * give fewer, as duplicates are dropped.
+		 *
+		 * @param p Piece
+		 * @param mirror Whether mirror images are allowed, too (for pieces that
+		 * 		   may be reflected in 3D).
+		 * @return Normalized orientations, each once.
+		 */
+		inline std::vector<shape> orientations(const shape &p, bool mirror=false) {
+			std::vector<shape> out(1, p);
+			normalize(out[0]);
+			for(std::size_t i=0; i<out.size(); ++i) {
+				for(int g=0; g<(mirror ? 4 : 3); ++g) {
+					shape q = out[i];
+					for(std::size_t j=0; j<q.size(); ++j) {
+						cell &c = q[j];
+						switch(g) {
+							case 0: c = cell(c.x, -c.z, c.y); break; // about x
+							case 1: c = cell(c.z, c.y, -c.x); break; // about y
+							case 2: c = cell(-c.y, c.x, c.z); break; // about z
+							default: c = cell(-c.x, c.y, c.z); // mirror
+						}
+					}
+					normalize(q);
+					if(std::find(out.begin(), out.end(), q) == out.end())
+						out.push_back(q);
+				}
+			}
+			return out;
+		}
+
+		/**
+		 * N queens.
+		 * Primary columns 1..n are ranks and n+1..2n files; secondary columns
+		 * 2n+1..4n-1 and 4n..6n-2 are the two families of diagonals, which may
+		 * stay empty. Row n*i+j puts a queen on rank i, file j.
+		 *
+		 * @tparam Solver Anything with setColumnNumber, reserve and addRow.
+		 * @param s Solver to fill
+		 * @param n Board size
+		 */
+		template <class Solver>
+		void queens(Solver &s, unsigned int n) {
+			s.setColumnNumber(2*n, 4*n - 2);
+			s.reserve(n*n, 4*n*n);
+			for(unsigned int i=0; i<n; ++i) {
+				for(unsigned int j=0; j<n; ++j) {
+					unsigned int r[4] = { 1 + i, n + 1 + j, 2*n + 1 + i + j, 4*n + i + n - 1 - j };
+					s.addRow(r, r + 4);
+				}
+			}
+		}
+
+		/**
+		 * Langford pairs: arrange two copies of each of 1..n in a row of 2n
+		 * slots, so that the copies of k have exactly k numbers between them.
+		 * Columns 1..n are numbers, n+1..3n slots, all primary. Each solution
+		 * is found together with its reversal.
+		 *
+		 * @tparam Solver Anything with setColumnNumber, reserve and addRow.
+		 * @param s Solver to fill
+		 * @param n Largest number
+		 */
+		template <class Solver>
+		void langford(Solver &s, unsigned int n) {
+			std::size_t rows = 0;
+			for(unsigned int k=1; k<=n; ++k)
+				if(k + 1 < 2*n)
+					rows += 2*n - k - 1;
+			s.setColumnNumber(3*n);
+			s.reserve(rows, 3*rows);
+			for(unsigned int k=1; k<=n; ++k) {
+				for(unsigned int i=0; i+k+1<2*n; ++i) {
+					unsigned int r[3] = { k, n + 1 + i, n + 1 + i + k + 1 };
+					s.addRow(r, r + 3);
+				}
+			}
+		}
+
+		/**
+		 * Pack pieces into a w x h x d box, each piece used exactly once and
+		 * every cell filled. Columns 1..pieces.size() are pieces, followed by
+		 * the cells (x + w*(y + h*z)); all are primary. Use d = 1 for
+		 * polyominoes. Solutions that differ by a symmetry of the box are all
+		 * reported.
+		 *
+		 * @tparam Solver Anything with setColumnNumber, reserve and addRow.
+		 * @param s Solver to fill
+		 * @param pieces Pieces
+		 * @param w Width
+		 * @param h Height
+		 * @param d Depth
+		 * @param mirror Whether pieces may be reflected (see orientations).
+		 */
+		template <class Solver>
+		void pack(Solver &s, const std::vector<shape> &pieces, int w, int h, int d=1, bool mirror=false) {
+			std::vector<std::vector<shape> > o(pieces.size());
+			std::size_t rows = 0, nonzeros = 0;
+			for(std::size_t p=0; p<pieces.size(); ++p) {
+				o[p] = orientations(pieces[p], mirror);
+				for(std::size_t i=0; i<o[p].size(); ++i) {
+					int bx = 0, by = 0, bz = 0;
+					for(std::size_t j=0; j<o[p][i].size(); ++j) {
+						bx = std::max(bx, o[p][i][j].x);
+						by = std::max(by, o[p][i][j].y);
+						bz = std::max(bz, o[p][i][j].z);
+					}
+					if(bx < w && by < h && bz < d) {
+						std::size_t n = static_cast<std::size_t>(w - bx) * (h - by) * (d - bz);
+						rows += n;
+						nonzeros += n * (pieces[p].size() + 1);
+					}
+				}
+			}
+			unsigned int base = pieces.size() + 1;
+			s.setColumnNumber(pieces.size() + w*h*d);
+			s.reserve(rows, nonzeros);
+			std::vector<unsigned int> r;
+			for(std::size_t p=0; p<pieces.size(); ++p) {
+				for(std::size_t i=0; i<o[p].size(); ++i) {
+					const shape &q = o[p][i];
+					for(int z=0; z<d; ++z)
+					for(int y=0; y<h; ++y)
+					for(int x=0; x<w; ++x) {
+						r.assign(1, p + 1);
+						for(std::size_t j=0; j<q.size() && r.size()==j+1; ++j) {
+							int cx = x + q[j].x, cy = y + q[j].y, cz = z + q[j].z;
+							if(cx < w && cy < h && cz < d)
+								r.push_back(base + cx + w*(cy + h*cz));
+						}
+						if(r.size() == q.size() + 1) {
+							std::sort(r.begin() + 1, r.end());
+							s.addRow(r.begin(), r.end());
+						}
+					}
+				}
+			}
+		}
+
+		/**
+		 * Parse a piece drawn as strings, '#' (or any other non-space, non-'.'
+		 * character) marking its cells.
+		 *
+		 * @param rows Drawing, rows separated by '/'
+		 */
+		inline shape piece(const char *rows) {
+			shape p;
+			for(int x=0, y=0; *rows; ++rows) {
+				if(*rows == '/') {
+					x = 0;
+					++y;
+					continue;
+				}
+				if(*rows != '.' && *rows != ' ')
+					p.push_back(cell(x, y));
+				++x;
+			}
+			return p;
+		}
+
+		/**
+		 * The twelve pentominoes (F I L N P T U V W X Y Z).
+		 */
+		inline std::vector<shape> pentominoes() {
+			static const char *d[] = { ".##/##./.#.", "#####", "####/#...", "###./..##", "###/##.",
+				"###/.#./.#.", "#.#/###", "#../#../###", "#../##./.##", ".#./###/.#.", "####/.#..", "##./.#./.##" };
+			std::vector<shape> p;
+			for(std::size_t i=0; i<sizeof(d)/sizeof(d[0]); ++i)
+				p.push_back(piece(d[i]));
+			return p;
+		}
+
+		/**
+		 * The seven Soma cube pieces; they fill a 3 x 3 x 3 box.
+		 */
+		inline std::vector<shape> soma() {
+			static const char *d[] = { "##/#.", "###/#..", "###/.#.", "##./.##" };
+			std::vector<shape> p;
+			for(std::size_t i=0; i<sizeof(d)/sizeof(d[0]); ++i)
+				p.push_back(piece(d[i]));
+			// the three nonplanar tetracubes
+			shape a = piece("##/#."), b = a, c = a;
+			a.push_back(cell(0, 0, 1));
+			b.push_back(cell(1, 0, 1));
+			c.push_back(cell(0, 1, 1));
+			p.push_back(a);
+			p.push_back(b);
+			p.push_back(c);
+			return p;
+		}
+	}
+}
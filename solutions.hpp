@@ -0,0 +1,752 @@
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+#include <unistd.h>
+
+/*
+ * Delivery of solutions found by a solver, kept apart from the solver
+ * itself: a queue that hands them to consumer threads, and a compact file
+ * to store them in. Solutions are row numbers, as given by
+ * dlxSolver::solutionRows or by the O vector of sharedSolver and
+ * fixedSolver, so nothing here depends on dlx.hpp.
+ */
+
+namespace kpfp {
+	namespace dlx {
+		/**
+		 * Bounded queue of solutions (as row numbers) from one search thread
+		 * to any number of consumer threads, so that slow consumers do not
+		 * stall the search. The ring is lock-free: every slot carries a
+		 * sequence number telling whether it is free or full for the current
+		 * lap, the producer owns the tail and consumers claim the head by
+		 * compare-and-swap. Locks are taken only on the slow paths: a thread
+		 * that finds the ring empty (or, with policy block, full) sleeps on a
+		 * condition variable, and the other side signals it only if it has
+		 * announced itself as waiting. What happens when the ring is full is
+		 * a policy:
+		 * - block: the producer waits for a free slot;
+		 * - drop: the solution is discarded (and counted);
+		 * - spill: the solution is appended to a temporary file, which
+		 *   consumers read from whenever they find the ring empty.
+		 */
+		class solutionQueue {
+		public:
+			/**
+			 * What push does when the ring is full.
+			 */
+			enum policy { block, drop, spill };
+		private:
+			std::size_t mask; /**< Slots - 1 */
+			std::size_t width; /**< Most rows per solution */
+			policy full; /**< Policy */
+			std::vector<unsigned long> seq; /**< Sequence number of every slot */
+			std::vector<unsigned int> data; /**< Row count and rows, width+1 per slot */
+			volatile unsigned long head; /**< Next slot to read */
+			volatile unsigned long tail; /**< Next slot to write */
+			volatile int closed; /**< No more pushes */
+			unsigned long pushed, dropped, spilled, peak; /**< Counters, written by the producer */
+			FILE *spillFile; /**< Overflow, with policy spill; written through stdio, read with pread */
+			unsigned long spillRead; /**< Offset of the next spilled solution to read */
+			unsigned long spillWrite; /**< End of the spilled solutions */
+			unsigned long spillFlushed; /**< End of what has reached the file */
+			std::vector<unsigned int> spillBuf; /**< Read-ahead of the spill file */
+			unsigned long spillBufAt; /**< Offset of spillBuf[0] */
+			pthread_mutex_t spillLock; /**< Guards all spill members */
+			volatile int popWaiting; /**< Consumers about to sleep or sleeping on nonEmpty */
+			volatile int pushWaiting; /**< Whether the producer is about to sleep or sleeping on nonFull and not yet woken */
+			pthread_mutex_t popLock; /**< Guards sleeping on nonEmpty */
+			pthread_mutex_t pushLock; /**< Guards sleeping on nonFull */
+			pthread_cond_t nonEmpty; /**< Signalled when a solution arrives or the queue closes */
+			pthread_cond_t nonFull; /**< Signalled when a slot is freed */
+
+			solutionQueue(const solutionQueue&);
+			solutionQueue &operator=(const solutionQueue&);
+
+			/**
+			 * Sequence number of slot i, as other threads see it.
+			 *
+			 * @param i Slot
+			 */
+			unsigned long slot(std::size_t i) const {
+				return *static_cast<const volatile unsigned long*>(&seq[i]);
+			}
+
+			/**
+			 * Wake a sleeping consumer, if any.
+			 *
+			 * @param all Wake them all
+			 */
+			void wakeConsumers(bool all) {
+				__sync_synchronize(); // publish before reading popWaiting
+				if(!popWaiting)
+					return;
+				pthread_mutex_lock(&popLock);
+				if(all)
+					pthread_cond_broadcast(&nonEmpty);
+				else
+					pthread_cond_signal(&nonEmpty);
+				pthread_mutex_unlock(&popLock);
+			}
+
+			/**
+			 * Append a solution to the spill file. Producer thread only.
+			 *
+			 * @param rows Row numbers
+			 * @param k Number of rows
+			 * @return false on I/O error.
+			 */
+			bool spillOut(const unsigned int *rows, unsigned int k) {
+				pthread_mutex_lock(&spillLock);
+				// after a failed write the file position is unknown, so the error sticks
+				bool ok = (spillFile || (spillFile = std::tmpfile())) && !std::ferror(spillFile)
+					&& std::fwrite(&k, sizeof(k), 1, spillFile) == 1
+					&& std::fwrite(rows, sizeof(*rows), k, spillFile) == k;
+				if(ok) {
+					spillWrite += (k + 1) * sizeof(k);
+					++spilled;
+				}
+				pthread_mutex_unlock(&spillLock);
+				if(ok)
+					wakeConsumers(false);
+				return ok;
+			}
+
+			/**
+			 * Read from the spill file.
+			 *
+			 * @param fd File
+			 * @param off Offset
+			 * @param p Buffer
+			 * @param n Length
+			 * @return false on I/O error or end of file.
+			 */
+			static bool readAt(int fd, unsigned long off, void *p, std::size_t n) {
+				char *q = static_cast<char*>(p);
+				while(n) {
+					ssize_t k = pread(fd, q, n, off);
+					if(k <= 0)
+						return false;
+					q += k;
+					off += k;
+					n -= k;
+				}
+				return true;
+			}
+
+			/**
+			 * Copy n numbers at offset off of the spill file, through spillBuf.
+			 * Caller holds spillLock; off + n numbers must be below spillWrite.
+			 *
+			 * @param off File offset
+			 * @param n Count
+			 * @param out Destination
+			 * @return false on I/O error.
+			 */
+			bool spillGet(unsigned long off, std::size_t n, unsigned int *out) {
+				const std::size_t u = sizeof(unsigned int);
+				if(off < spillBufAt || off + n*u > spillBufAt + spillBuf.size()*u) {
+					if(off + n*u > spillFlushed) {
+						if(std::fflush(spillFile) != 0)
+							return false;
+						spillFlushed = spillWrite;
+					}
+					spillBuf.resize(std::max(n, std::min(static_cast<std::size_t>(1) << 14, static_cast<std::size_t>((spillFlushed - off) / u))));
+					spillBufAt = off;
+					if(!readAt(fileno(spillFile), off, &spillBuf[0], spillBuf.size()*u)) {
+						spillBuf.clear();
+						return false;
+					}
+				}
+				const unsigned int *p = &spillBuf[(off - spillBufAt) / u];
+				std::copy(p, p + n, out);
+				return true;
+			}
+
+			/**
+			 * Take one solution from the spill file.
+			 *
+			 * @param out Receives the rows.
+			 * @return false if none is left (or it cannot be read).
+			 */
+			bool spillIn(std::vector<unsigned int> &out) {
+				pthread_mutex_lock(&spillLock);
+				unsigned int k = 0;
+				bool ok = spillRead < spillWrite && spillGet(spillRead, 1, &k);
+				if(ok) {
+					out.resize(k);
+					ok = k == 0 || spillGet(spillRead + sizeof(k), k, &out[0]);
+				}
+				// a read error loses the rest of the file rather than retrying forever
+				spillRead = ok ? spillRead + (k + 1) * sizeof(k) : spillWrite;
+				pthread_mutex_unlock(&spillLock);
+				return ok;
+			}
+
+			/**
+			 * Take one solution from the ring.
+			 *
+			 * @param out Receives the rows.
+			 * @return false if the ring is empty.
+			 */
+			bool tryPop(std::vector<unsigned int> &out) {
+				for(;;) {
+					unsigned long pos = head;
+					std::size_t i = pos & mask;
+					unsigned long s = slot(i);
+					if(s != pos + 1) {
+						if(static_cast<long>(s - (pos + 1)) < 0)
+							return false; // not written yet
+						continue; // another consumer took it
+					}
+					if(!__sync_bool_compare_and_swap(&head, pos, pos + 1))
+						continue;
+					__sync_synchronize();
+					const unsigned int *d = &data[i * (width + 1)];
+					out.assign(d + 1, d + 1 + d[0]);
+					__sync_synchronize();
+					seq[i] = pos + mask + 1; // free for the next lap
+					__sync_synchronize(); // free the slot before reading pushWaiting
+					// wake the producer once the ring has drained to half, just once per sleep
+					if(pushWaiting && tail - head <= (mask + 1) / 2 && __sync_bool_compare_and_swap(&pushWaiting, 1, 0)) {
+						pthread_mutex_lock(&pushLock);
+						pthread_cond_signal(&nonFull);
+						pthread_mutex_unlock(&pushLock);
+					}
+					return true;
+				}
+			}
+		public:
+			/**
+			 * Constructor.
+			 *
+			 * @param slots Capacity of the ring, rounded up to a power of 2.
+			 * @param maxRows Most rows a solution can have: the number of primary columns,
+			 * 		  plus any forced rows without a primary column. Longer solutions are rejected.
+			 * @param p Policy when full.
+			 */
+			solutionQueue(std::size_t slots, std::size_t maxRows, policy p=block)
+				: width(maxRows), full(p), head(0), tail(0), closed(0),
+				  pushed(0), dropped(0), spilled(0), peak(0), spillFile(0),
+				  spillRead(0), spillWrite(0), spillFlushed(0), spillBufAt(0),
+				  popWaiting(0), pushWaiting(0) {
+				std::size_t n = 1;
+				while(n < slots)
+					n *= 2;
+				mask = n - 1;
+				seq.resize(n);
+				for(std::size_t i=0; i<n; ++i)
+					seq[i] = i;
+				data.resize(n * (width + 1));
+				pthread_mutex_init(&spillLock, 0);
+				pthread_mutex_init(&popLock, 0);
+				pthread_mutex_init(&pushLock, 0);
+				pthread_cond_init(&nonEmpty, 0);
+				pthread_cond_init(&nonFull, 0);
+			}
+
+			~solutionQueue() {
+				if(spillFile)
+					std::fclose(spillFile);
+				pthread_mutex_destroy(&spillLock);
+				pthread_mutex_destroy(&popLock);
+				pthread_mutex_destroy(&pushLock);
+				pthread_cond_destroy(&nonEmpty);
+				pthread_cond_destroy(&nonFull);
+			}
+
+			/**
+			 * Hand a solution over to the consumers. Producer thread only.
+			 *
+			 * @param rows Row numbers
+			 * @param k Number of rows, at most maxRows.
+			 * @return false if the solution was dropped (or could not be spilled),
+			 * 		   or rejected for having more than maxRows rows.
+			 */
+			bool push(const unsigned int *rows, unsigned int k) {
+				if(k > width)
+					return false; // would run into the next slot
+				unsigned long pos = tail;
+				std::size_t i = pos & mask;
+				if(slot(i) != pos) { // full
+					if(full == drop) {
+						++dropped;
+						return false;
+					}
+					if(full == spill)
+						return spillOut(rows, k);
+					pthread_mutex_lock(&pushLock);
+					for(;;) {
+						pushWaiting = 1; // cleared by the consumer that wakes us
+						__sync_synchronize(); // announce before looking again
+						if(slot(i) == pos)
+							break;
+						pthread_cond_wait(&nonFull, &pushLock);
+					}
+					pushWaiting = 0;
+					pthread_mutex_unlock(&pushLock);
+				}
+				unsigned int *d = &data[i * (width + 1)];
+				d[0] = k;
+				std::copy(rows, rows + k, d + 1);
+				__sync_synchronize();
+				seq[i] = pos + 1;
+				tail = pos + 1;
+				++pushed;
+				peak = std::max(peak, pos + 1 - head);
+				__sync_synchronize();
+				if(head == pos) // the ring was empty, so consumers may be asleep
+					wakeConsumers(false);
+				return true;
+			}
+
+			/**
+			 * Push a solution given as a vector.
+			 *
+			 * @param rows Row numbers
+			 */
+			bool push(const std::vector<unsigned int> &rows) {
+				return push(rows.empty() ? 0 : &rows[0], rows.size());
+			}
+
+			/**
+			 * Take the next solution, waiting for one if necessary.
+			 *
+			 * @param out Receives the rows.
+			 * @return false once the queue is closed and drained.
+			 */
+			bool pop(std::vector<unsigned int> &out) {
+				if(tryPop(out))
+					return true;
+				pthread_mutex_lock(&popLock);
+				__sync_add_and_fetch(&popWaiting, 1); // announce before looking again
+				bool ok;
+				for(;;) {
+					int c = closed;
+					__sync_synchronize(); // everything pushed before close is visible now
+					ok = tryPop(out) || (full == spill && spillIn(out));
+					if(ok || c)
+						break;
+					pthread_cond_wait(&nonEmpty, &popLock);
+				}
+				if(ok && popWaiting > 1 && depth())
+					pthread_cond_signal(&nonEmpty); // pass the wakeup on while there is work
+				__sync_sub_and_fetch(&popWaiting, 1);
+				pthread_mutex_unlock(&popLock);
+				return ok;
+			}
+
+			/**
+			 * Signal the end of the stream and wake all sleeping consumers.
+			 * Producer thread only.
+			 */
+			void close() {
+				__sync_synchronize();
+				closed = 1;
+				wakeConsumers(true);
+			}
+
+			/**
+			 * Solutions in the ring now.
+			 */
+			std::size_t depth() const { return tail - head; }
+
+			/**
+			 * Most solutions that were in the ring at once.
+			 */
+			std::size_t maxDepth() const { return peak; }
+
+			/**
+			 * Solutions passed through the ring.
+			 */
+			unsigned long pushCount() const { return pushed; }
+
+			/**
+			 * Solutions discarded with policy drop.
+			 */
+			unsigned long dropCount() const { return dropped; }
+
+			/**
+			 * Solutions written to disk with policy spill.
+			 */
+			unsigned long spillCount() const { return spilled; }
+		};
+
+		/**
+		 * State of a consumer thread.
+		 */
+		template <class Consumer>
+		struct drainTask {
+			Consumer *c; /**< Consumer owned by this thread */
+			solutionQueue *q; /**< Queue */
+		};
+
+		/**
+		 * Thread entry point of a consumer.
+		 *
+		 * @param p Pointer to drainTask<Consumer>
+		 */
+		template <class Consumer>
+		void *drainRun(void *p) {
+			drainTask<Consumer> *t = static_cast<drainTask<Consumer>*>(p);
+			std::vector<unsigned int> rows;
+			while(t->q->pop(rows))
+				t->c->consume(static_cast<const std::vector<unsigned int>&>(rows));
+			return 0;
+		}
+
+		/**
+		 * Consumer threads draining a solutionQueue.
+		 * Threads start with the object; join() (or the destructor) waits for
+		 * them, which happens once the producer has closed the queue. If a
+		 * thread cannot be created, no more are started; size() tells how many
+		 * run, and with none the caller has to pop the queue itself.
+		 *
+		 * @tparam Consumer Class with consume(const std::vector<unsigned int> &rows).
+		 */
+		template <class Consumer>
+		class drain {
+			std::vector<drainTask<Consumer> > t; /**< Tasks */
+			std::vector<pthread_t> th; /**< Threads */
+
+			drain(const drain&);
+			drain &operator=(const drain&);
+		public:
+			/**
+			 * Start consumers.
+			 *
+			 * @param q Queue
+			 * @param c Array of n consumers.
+			 * @param n Number of consumers (threads).
+			 */
+			drain(solutionQueue &q, Consumer **c, unsigned int n) : t(n), th(n) {
+				for(unsigned int i=0; i<n; ++i) {
+					t[i].c = c[i];
+					t[i].q = &q;
+					if(pthread_create(&th[i], 0, drainRun<Consumer>, &t[i]) != 0) {
+						th.resize(i);
+						break;
+					}
+				}
+			}
+
+			/**
+			 * Number of consumer threads started and not yet joined.
+			 */
+			std::size_t size() const { return th.size(); }
+
+			/**
+			 * Wait for all consumers to finish.
+			 */
+			void join() {
+				for(std::size_t i=0; i<th.size(); ++i)
+					pthread_join(th[i], 0);
+				th.clear();
+			}
+
+			~drain() { join(); }
+		};
+
+		/**
+		 * Trailer of a solution archive (see archiveWriter).
+		 */
+		struct archiveTrailer {
+			unsigned long count; /**< Solutions */
+			unsigned long stride; /**< Solutions per index entry */
+			unsigned long index; /**< Offset of the index */
+			char magic[8]; /**< "DLXSOL1" */
+		};
+
+		/**
+		 * Compact file of solutions (as row numbers).
+		 * Solutions found one after another by search share the rows chosen
+		 * at the top of the tree, so each one is stored as the length of the
+		 * prefix it has in common with the previous solution, the length of
+		 * the rest and the rest itself, every row as the zigzag-encoded
+		 * difference from the row before it. All numbers are varints (7 bits
+		 * per byte, low first). Every stride-th solution is stored whole and
+		 * its offset recorded in an index at the end of the file, after which
+		 * comes an archiveTrailer; archiveReader uses it for random access.
+		 *
+		 * Rows are kept in the order given, which for solutionRows is the order
+		 * of selection: sorting them would break the shared prefixes.
+		 */
+		class archiveWriter {
+			FILE *f; /**< File, 0 if closed */
+			unsigned long stride; /**< Solutions per index entry */
+			unsigned long n; /**< Solutions written */
+			unsigned long pos; /**< Bytes written, including buf */
+			std::vector<unsigned int> last; /**< Previous solution */
+			std::vector<unsigned long> index; /**< Offsets of every stride-th solution */
+			std::vector<unsigned char> buf; /**< Pending output */
+
+			archiveWriter(const archiveWriter&);
+			archiveWriter &operator=(const archiveWriter&);
+
+			/**
+			 * Append a varint to buf.
+			 *
+			 * @param v Value
+			 */
+			void put(unsigned long v) {
+				while(v >= 0x80) {
+					buf.push_back(static_cast<unsigned char>(v | 0x80));
+					v >>= 7;
+				}
+				buf.push_back(static_cast<unsigned char>(v));
+			}
+
+			/**
+			 * Write buf out and empty it.
+			 *
+			 * @return false on I/O error.
+			 */
+			bool flush() {
+				bool ok = buf.empty() || std::fwrite(&buf[0], 1, buf.size(), f) == buf.size();
+				buf.clear();
+				return ok;
+			}
+		public:
+			/**
+			 * Constructor. Creates (or truncates) the file.
+			 *
+			 * @param path File name
+			 * @param stride_ Solutions per index entry: a lower value makes seeking faster and the file larger.
+			 */
+			archiveWriter(const char *path, unsigned long stride_=256)
+				: f(std::fopen(path, "wb")), stride(stride_ ? stride_ : 1), n(0), pos(8) {
+				if(f && std::fwrite("DLXSOL1", 1, 8, f) != 8) {
+					std::fclose(f);
+					f = 0;
+				}
+			}
+
+			~archiveWriter() { close(); }
+
+			/**
+			 * Whether the file is open and no write failed.
+			 */
+			bool good() const { return f != 0; }
+
+			/**
+			 * Append a solution.
+			 *
+			 * @param rows Row numbers
+			 * @param k Number of rows
+			 * @return false on I/O error.
+			 */
+			bool write(const unsigned int *rows, unsigned int k) {
+				if(!f)
+					return false;
+				std::size_t p = 0;
+				if(n % stride == 0)
+					index.push_back(pos + buf.size());
+				else
+					while(p < k && p < last.size() && rows[p] == last[p])
+						++p;
+				put(p);
+				put(k - p);
+				unsigned int prev = p ? rows[p-1] : 0;
+				for(std::size_t i=p; i<k; ++i) {
+					long d = static_cast<long>(rows[i]) - static_cast<long>(prev);
+					put(d < 0 ? (static_cast<unsigned long>(-(d + 1)) << 1) | 1 : static_cast<unsigned long>(d) << 1);
+					prev = rows[i];
+				}
+				last.assign(rows, rows + k);
+				++n;
+				if(buf.size() >= 1 << 16) {
+					pos += buf.size();
+					if(!flush()) {
+						std::fclose(f);
+						f = 0;
+						return false;
+					}
+				}
+				return true;
+			}
+
+			/**
+			 * Append a solution given as a vector.
+			 *
+			 * @param rows Row numbers
+			 */
+			bool write(const std::vector<unsigned int> &rows) {
+				return write(rows.empty() ? 0 : &rows[0], rows.size());
+			}
+
+			/**
+			 * Write the index and close the file. Called by the destructor.
+			 *
+			 * @return false on I/O error (now or earlier).
+			 */
+			bool close() {
+				if(!f)
+					return false;
+				pos += buf.size();
+				archiveTrailer t;
+				t.count = n;
+				t.stride = stride;
+				t.index = pos;
+				std::memcpy(t.magic, "DLXSOL1", 8);
+				bool ok = flush()
+					&& (index.empty() || std::fwrite(&index[0], sizeof(index[0]), index.size(), f) == index.size())
+					&& std::fwrite(&t, sizeof(t), 1, f) == 1;
+				ok = std::fclose(f) == 0 && ok;
+				f = 0;
+				return ok;
+			}
+
+			/**
+			 * Solutions written.
+			 */
+			unsigned long count() const { return n; }
+
+			/**
+			 * Bytes of solutions written so far (without index and trailer).
+			 */
+			unsigned long bytes() const { return pos + buf.size(); }
+		};
+
+		/**
+		 * Reader of a file made by archiveWriter: solutions one after another
+		 * (next) or by number (seek, get).
+		 * The file is not trusted: the trailer and index are checked against
+		 * the file size before anything is allocated, and no solution may
+		 * claim more rows than there are bytes left to encode them.
+		 */
+		class archiveReader {
+			FILE *f; /**< File, 0 if not open */
+			archiveTrailer t; /**< Trailer */
+			unsigned long n; /**< Number of the solution next returns */
+			unsigned long at; /**< Offset of the next byte to read */
+			std::vector<unsigned long> index; /**< Offsets of every stride-th solution */
+			std::vector<unsigned int> last; /**< Previous solution */
+
+			archiveReader(const archiveReader&);
+			archiveReader &operator=(const archiveReader&);
+
+			/**
+			 * Read a varint.
+			 *
+			 * @param v Value
+			 * @return false on end of file or a malformed number.
+			 */
+			bool read(unsigned long &v) {
+				v = 0;
+				for(int s=0; s<64; s+=7) {
+					int c = at < t.index ? getc(f) : EOF;
+					if(c == EOF)
+						return false;
+					++at;
+					v |= static_cast<unsigned long>(c & 0x7f) << s;
+					if(!(c & 0x80))
+						return true;
+				}
+				return false;
+			}
+		public:
+			/**
+			 * Constructor. Opens the file and reads its index.
+			 *
+			 * @param path File name
+			 */
+			archiveReader(const char *path) : f(std::fopen(path, "rb")), n(0), at(8) {
+				char m[8];
+				long size = 0;
+				bool ok = f && std::fread(m, 1, 8, f) == 8 && std::memcmp(m, "DLXSOL1", 8) == 0
+					&& std::fseek(f, -static_cast<long>(sizeof(t)), SEEK_END) == 0
+					&& (size = std::ftell(f)) >= 8
+					&& std::fread(&t, sizeof(t), 1, f) == 1 && std::memcmp(t.magic, "DLXSOL1", 8) == 0
+					&& t.stride && t.index >= 8 && t.index <= static_cast<unsigned long>(size);
+				// the index fills the space between the solutions and the trailer,
+				// and every solution takes at least two bytes (p and k)
+				unsigned long entries = ok ? t.count / t.stride + (t.count % t.stride != 0) : 0;
+				ok = ok && (size - t.index) / sizeof(unsigned long) == entries
+					&& (size - t.index) % sizeof(unsigned long) == 0
+					&& t.count <= (t.index - 8) / 2;
+				if(ok) {
+					index.resize(entries);
+					ok = std::fseek(f, t.index, SEEK_SET) == 0
+						&& (index.empty() || std::fread(&index[0], sizeof(index[0]), index.size(), f) == index.size())
+						&& std::fseek(f, 8, SEEK_SET) == 0;
+					for(std::size_t i=0; i<index.size() && ok; ++i)
+						ok = index[i] >= 8 && index[i] < t.index;
+				}
+				if(!ok && f) {
+					std::fclose(f);
+					f = 0;
+				}
+			}
+
+			~archiveReader() {
+				if(f)
+					std::fclose(f);
+			}
+
+			/**
+			 * Whether the archive was opened.
+			 */
+			bool good() const { return f != 0; }
+
+			/**
+			 * Number of solutions in the archive.
+			 */
+			unsigned long size() const { return f ? t.count : 0; }
+
+			/**
+			 * Read the next solution.
+			 *
+			 * @param out Receives the rows.
+			 * @return false at the end of the archive or on error.
+			 */
+			bool next(std::vector<unsigned int> &out) {
+				unsigned long p, k, d;
+				if(!f || n >= t.count || !read(p) || !read(k) || p > last.size() || k > t.index - at)
+					return false; // every row takes at least a byte
+				last.resize(p + k);
+				unsigned int prev = p ? last[p-1] : 0;
+				for(unsigned long i=p; i<p+k; ++i) {
+					if(!read(d))
+						return false;
+					prev += d & 1 ? ~static_cast<unsigned int>(d >> 1) : static_cast<unsigned int>(d >> 1);
+					last[i] = prev;
+				}
+				out = last;
+				++n;
+				return true;
+			}
+
+			/**
+			 * Position the reader so that next returns solution i.
+			 * Decodes at most stride-1 solutions.
+			 *
+			 * @param i Solution number
+			 * @return false if there is no such solution.
+			 */
+			bool seek(unsigned long i) {
+				if(!f || i >= t.count || std::fseek(f, index[i / t.stride], SEEK_SET) != 0)
+					return false;
+				at = index[i / t.stride];
+				n = i / t.stride * t.stride;
+				last.clear();
+				std::vector<unsigned int> skip;
+				while(n < i)
+					if(!next(skip))
+						return false;
+				return true;
+			}
+
+			/**
+			 * Read solution i.
+			 *
+			 * @param i Solution number
+			 * @param out Receives the rows.
+			 */
+			bool get(unsigned long i, std::vector<unsigned int> &out) {
+				return seek(i) && next(out);
+			}
+		};
+	}
+}
@@ -0,0 +1,115 @@
+#include "dlx.hpp"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace kpfp;
+
+/*
+ * Batch 9x9 Sudoku solver.
+ *
+ * Reads puzzles from stdin, one per line: 81 cells row by row, 1-9 for
+ * givens, 0 or . for blanks (shorter lines are skipped). For every puzzle
+ * writes a line with its solution (or the puzzle itself if it has none)
+ * followed by the number of solutions, 0, 1 or 2 (meaning "more than one").
+ * Puzzles per second go to stderr.
+ *
+ * The 729x324 matrix is built once; every thread gets its own copy of it
+ * and applies each puzzle's givens as forced rows, which search undoes
+ * afterwards. Input is processed in chunks, so it may be arbitrarily long.
+ *
+ * Usage: sudoku [threads]
+ */
+
+static const unsigned int chunk = 1 << 14; /* Puzzles per chunk */
+
+struct Sudoku : public dlxSolver<Sudoku> {
+	unsigned long current; /* Puzzle being solved, set by batch() */
+	vector<string> *out; /* Solutions of the chunk */
+	vector<int> *found; /* Number of solutions of each puzzle in the chunk */
+
+	Sudoku() : current(0), out(0), found(0) {}
+
+	void solution(unsigned int k) {
+		if((*found)[current]++ == 0) {
+			string &s = (*out)[current];
+			for(unsigned int i=0; i<k; ++i) {
+				int cell = 0, digit = 0;
+				node *n = O[i];
+				do {
+					if(n->C->N <= 81)
+						cell = n->C->N - 1;
+					else if(n->C->N <= 162)
+						digit = (n->C->N - 82) % 9;
+					n = n->R;
+				} while(n != O[i]);
+				s[cell] = static_cast<char>('1' + digit);
+			}
+		} else {
+			halt = true; // not unique, no need to look further
+		}
+	}
+};
+
+static double now() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+int main(int argc, char **argv) {
+	long n = argc > 1 ? atol(argv[1]) : sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned int threads = n > 0 ? static_cast<unsigned int>(n) : 1;
+
+	// row 9*cell+digit puts digit into cell: it fills the cell and uses
+	// the digit once in the cell's row, column and box
+	Sudoku proto;
+	proto.setColumnNumber(4*81);
+	for(int r=0; r<9; ++r)
+		for(int c=0; c<9; ++c)
+			for(int d=0; d<9; ++d) {
+				int cols[4] = { 1 + 9*r + c, 82 + 9*r + d, 163 + 9*c + d, 244 + 9*(r/3*3 + c/3) + d };
+				proto.addRow(cols, cols + 4);
+			}
+	vector<Sudoku> w(threads, proto);
+	vector<Sudoku*> wp(threads);
+	for(unsigned int i=0; i<threads; ++i)
+		wp[i] = &w[i];
+
+	unsigned long total = 0;
+	double t = now();
+	vector<dlx::query> q;
+	vector<string> out;
+	vector<int> found;
+	string line;
+	for(bool more=true; more; ) {
+		q.clear();
+		out.clear();
+		while(q.size() < chunk && (more = !getline(cin, line).fail())) {
+			if(line.size() < 81)
+				continue;
+			dlx::query p;
+			for(unsigned int i=0; i<81; ++i)
+				if(line[i] >= '1' && line[i] <= '9')
+					p.force.push_back(9*i + (line[i] - '1'));
+			q.push_back(p);
+			out.push_back(line.substr(0, 81));
+		}
+		found.assign(q.size(), 0);
+		for(unsigned int i=0; i<threads; ++i) {
+			w[i].out = &out;
+			w[i].found = &found;
+		}
+		batch(&wp[0], threads, q);
+		for(size_t i=0; i<out.size(); ++i)
+			cout << out[i] << " " << found[i] << "\n";
+		total += q.size();
+	}
+	t = now() - t;
+	cerr << total << " puzzles in " << t << " s, " << total / t << " puzzles/s\n";
+
+	return 0;
+}
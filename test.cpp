@@ -0,0 +1,86 @@
+#include "dlx.hpp"
+#include <iostream>
+#include <vector>
+#include <sys/time.h>
+
+using namespace std;
+using namespace kpfp;
+
+/*
+ * Regression checks, run by make check.
+ *
+ * Prints each failed check and exits with 1 if any failed.
+ */
+
+static int failed = 0;
+
+static void check(bool ok, const char *what) {
+	if(!ok) {
+		cerr << "FAILED: " << what << "\n";
+		++failed;
+	}
+}
+
+static double now() {
+	timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+/*
+ * Solver that reports how often its node arena moved.
+ */
+template <class Traits>
+struct Grower : public dlxSolver<Grower<Traits>, Traits> {
+	typedef dlxSolver<Grower<Traits>, Traits> base;
+	unsigned int moves; /* Node arena reallocations seen by addColumn */
+
+	Grower() : moves(0) {}
+	void solution(unsigned int) {}
+	typename base::index_type addColumn(bool primary) {
+		const void *p = &this->nodes[0];
+		typename base::index_type x = base::addColumn(primary);
+		moves += p != &this->nodes[0];
+		return x;
+	}
+};
+
+/*
+ * Add n columns, the first two primary, before any row, then two rows with
+ * one solution. Arena moves must stay logarithmic in n and n columns must
+ * take well under a second (a quadratic addColumn takes minutes).
+ */
+template <class Traits>
+static void columnsFirst(unsigned int n, const char *name) {
+	Grower<Traits> s;
+	unsigned int log = 0;
+	for(unsigned int m=n; m; m/=2)
+		++log;
+	double t = now();
+	for(unsigned int i=0; i<n; ++i) {
+		s.addColumn(i < 2);
+		if(s.moves > 2*log + 2) { // failed already, don't wait minutes for the rest
+			n = i + 1;
+			break;
+		}
+	}
+	t = now() - t;
+	vector<unsigned int> r(2);
+	r[0] = 1;
+	r[1] = n;
+	s.addRow(r.begin(), r.end());
+	r[0] = 2;
+	r[1] = n / 2;
+	s.addRow(r.begin(), r.end());
+	unsigned long solutions = s.count();
+	cout << name << ": " << n << " columns in " << t << " s, " << s.moves << " arena moves\n";
+	check(s.moves <= 2*log + 2, "addColumn before the first row moves the arena O(log n) times");
+	check(t < 1, "addColumn before the first row takes amortized constant time");
+	check(solutions == 1, "a matrix built column by column is searched correctly");
+}
+
+int main() {
+	columnsFirst<dlx::traits<> >(200000, "pointer links");
+	columnsFirst<dlx::compactTraits>(40000, "compact links");
+	return failed ? 1 : 0;
+}